@@ -0,0 +1,400 @@
+/* Drives the broadway daemon code with a scripted WebSocket client in
+ * the same process and reports how many bytes the updates take on the
+ * wire and how long they take to encode and deliver.
+ *
+ * The client runs on its own thread, reads and decompresses the frames,
+ * walks the commands in them and acknowledges every surface flush the
+ * way broadway.js does. The main thread paints a scrolling list of
+ * text into a window and waits for each frame to be acknowledged.
+ */
+
+#include "config.h"
+#include <string.h>
+#include <stdlib.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+#include <cairo.h>
+
+#include "broadway-server.h"
+
+static int port = 8090;
+static int n_frames = 200;
+static int width = 1024;
+static int height = 768;
+static gboolean deflate = FALSE;
+static gboolean png = FALSE;
+
+static GOptionEntry options[] = {
+  { "port", 'p', 0, G_OPTION_ARG_INT, &port, "Port to listen on", "PORT" },
+  { "frames", 'n', 0, G_OPTION_ARG_INT, &n_frames, "Number of frames", "N" },
+  { "width", 0, 0, G_OPTION_ARG_INT, &width, "Window width", "WIDTH" },
+  { "height", 0, 0, G_OPTION_ARG_INT, &height, "Window height", "HEIGHT" },
+  { "deflate", 'd', 0, G_OPTION_ARG_NONE, &deflate, "Negotiate permessage-deflate", NULL },
+  { "png", 0, 0, G_OPTION_ARG_NONE, &png, "Use PNG images instead of tiles", NULL },
+  { NULL }
+};
+
+typedef struct {
+  GSocketConnection *connection;
+  GDataInputStream *in;
+  GOutputStream *out;
+  GConverter *decompressor;
+  GByteArray *payload;
+
+  gboolean deflate_accepted;
+  volatile gint flushes;
+  guint64 wire_bytes;
+  guint64 payload_bytes;
+} Client;
+
+static Client client;
+
+/* The daemon side doesn't talk to any GDK clients here */
+void
+broadway_events_got_input (BroadwayInputMsg *message,
+			   gint32 client_id)
+{
+}
+
+static void
+send_text (Client     *c,
+	   const char *text)
+{
+  guint8 frame[128];
+  guint8 mask[4] = { 0x12, 0x34, 0x56, 0x78 };
+  gsize len, i;
+
+  len = strlen (text);
+  g_assert (len <= 125);
+
+  frame[0] = 0x80 | 0x1; /* fin, text */
+  frame[1] = 0x80 | len; /* masked */
+  memcpy (frame + 2, mask, 4);
+  for (i = 0; i < len; i++)
+    frame[6 + i] = text[i] ^ mask[i % 4];
+
+  g_output_stream_write_all (c->out, frame, 6 + len, NULL, NULL, NULL);
+}
+
+static guint32
+get_16 (const guint8 *p)
+{
+  return p[0] | p[1] << 8;
+}
+
+static guint32
+get_32 (const guint8 *p)
+{
+  return p[0] | p[1] << 8 | p[2] << 16 | (guint32)p[3] << 24;
+}
+
+static void
+handle_commands (Client       *c,
+		 const guint8 *p,
+		 gsize         len)
+{
+  const guint8 *end = p + len;
+  char ack[64];
+  guint32 serial, flags;
+  char op;
+
+  while (p < end)
+    {
+      op = p[0];
+      serial = get_32 (p + 1);
+      p += 5;
+
+      switch (op)
+	{
+	case 's': p += 11; break;
+	case 'S': case 'H': case 'd': p += 2; break;
+	case 'p': p += 4; break;
+	case 'g': p += 3; break;
+	case 'u': case 'L': case 'D': break;
+	case 'm':
+	  flags = p[2];
+	  p += 3;
+	  if (flags & 1)
+	    p += 4;
+	  if (flags & 2)
+	    p += 4;
+	  break;
+	case 'b':
+	  p += 4 + 8 * get_16 (p + 2) + 4;
+	  break;
+	case 'i':
+	  p += 6;
+	  p += 4 + get_32 (p);
+	  break;
+	case 't':
+	  p += 10;
+	  p += 4 + get_32 (p);
+	  break;
+	case 'f':
+	  p += 2;
+	  /* Count first, so the main thread sees it once the ack arrives */
+	  g_atomic_int_inc (&c->flushes);
+	  g_snprintf (ack, sizeof (ack), "A%u,0", serial);
+	  send_text (c, ack);
+	  break;
+	case 'l':
+	  g_printerr ("The daemon asks for a password, remove broadway.passwd\n");
+	  exit (1);
+	default:
+	  g_printerr ("Unknown op %c\n", op);
+	  exit (1);
+	}
+    }
+}
+
+static gboolean
+read_frame (Client *c)
+{
+  static const guint8 tail[4] = { 0x00, 0x00, 0xff, 0xff };
+  guint8 header[10];
+  guint8 *data;
+  gsize header_len, len;
+  gboolean compressed;
+
+  if (!g_input_stream_read_all (G_INPUT_STREAM (c->in), header, 2, &len, NULL, NULL) || len < 2)
+    return FALSE;
+
+  compressed = header[0] & 0x40;
+  header_len = 2;
+  len = header[1] & 0x7f;
+  if (len == 126)
+    {
+      g_input_stream_read_all (G_INPUT_STREAM (c->in), header + 2, 2, NULL, NULL, NULL);
+      len = GUINT16_FROM_BE (*(guint16 *)(header + 2));
+      header_len += 2;
+    }
+  else if (len == 127)
+    {
+      g_input_stream_read_all (G_INPUT_STREAM (c->in), header + 2, 8, NULL, NULL, NULL);
+      len = GUINT64_FROM_BE (*(guint64 *)(header + 2));
+      header_len += 8;
+    }
+
+  data = g_malloc (len);
+  if (!g_input_stream_read_all (G_INPUT_STREAM (c->in), data, len, NULL, NULL, NULL))
+    {
+      g_free (data);
+      return FALSE;
+    }
+
+  c->wire_bytes += header_len + len;
+
+  if ((header[0] & 0x0f) == 0x2)
+    {
+      if (compressed)
+	{
+	  gsize bytes_read, bytes_written, i;
+	  const guint8 *in[2] = { data, tail };
+	  gsize in_len[2] = { len, 4 };
+
+	  g_byte_array_set_size (c->payload, 0);
+	  for (i = 0; i < 2; i++)
+	    {
+	      while (TRUE)
+		{
+		  gsize old_len = c->payload->len;
+		  GConverterResult res;
+
+		  g_byte_array_set_size (c->payload, old_len + 65536);
+		  res = g_converter_convert (c->decompressor,
+					     in[i], in_len[i],
+					     c->payload->data + old_len, 65536,
+					     G_CONVERTER_FLUSH,
+					     &bytes_read, &bytes_written, NULL);
+		  g_assert (res != G_CONVERTER_ERROR);
+		  g_byte_array_set_size (c->payload, old_len + bytes_written);
+		  in[i] += bytes_read;
+		  in_len[i] -= bytes_read;
+		  if (in_len[i] == 0 && bytes_written < 65536)
+		    break;
+		}
+	    }
+	  handle_commands (c, c->payload->data, c->payload->len);
+	  c->payload_bytes += c->payload->len;
+	}
+      else
+	{
+	  handle_commands (c, data, len);
+	  c->payload_bytes += len;
+	}
+    }
+
+  g_free (data);
+
+  return TRUE;
+}
+
+static gpointer
+client_thread (gpointer data)
+{
+  Client *c = data;
+  GSocketClient *socket_client;
+  GError *error = NULL;
+  char *request, *line;
+
+  socket_client = g_socket_client_new ();
+  c->connection = g_socket_client_connect_to_host (socket_client, "127.0.0.1", port, NULL, &error);
+  if (c->connection == NULL)
+    {
+      g_printerr ("Can't connect: %s\n", error->message);
+      exit (1);
+    }
+  g_object_unref (socket_client);
+
+  c->in = g_data_input_stream_new (g_io_stream_get_input_stream (G_IO_STREAM (c->connection)));
+  c->out = g_io_stream_get_output_stream (G_IO_STREAM (c->connection));
+  c->payload = g_byte_array_new ();
+  c->decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+
+  request = g_strdup_printf ("GET /%s HTTP/1.1\r\n"
+			     "Host: 127.0.0.1:%d\r\n"
+			     "Upgrade: websocket\r\n"
+			     "Connection: Upgrade\r\n"
+			     "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+			     "Sec-WebSocket-Version: 13\r\n"
+			     "Sec-WebSocket-Protocol: broadway\r\n"
+			     "%s"
+			     "\r\n",
+			     png ? "socket-bin" : "socket-tiles",
+			     port,
+			     deflate ? "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n" : "");
+  g_output_stream_write_all (c->out, request, strlen (request), NULL, NULL, NULL);
+  g_free (request);
+
+  while ((line = g_data_input_stream_read_line (c->in, NULL, NULL, NULL)) != NULL)
+    {
+      g_strchomp (line);
+      if (g_str_has_prefix (line, "Sec-WebSocket-Extensions: permessage-deflate"))
+	c->deflate_accepted = TRUE;
+      if (*line == 0)
+	{
+	  g_free (line);
+	  break;
+	}
+      g_free (line);
+    }
+
+  while (read_frame (c))
+    ;
+
+  return NULL;
+}
+
+static void
+wait_for_flushes (gint n)
+{
+  while (g_atomic_int_get (&client.flushes) < n)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+paint_frame (cairo_surface_t *surface,
+	     int              frame)
+{
+  cairo_t *cr;
+  int i, y;
+  char text[64];
+
+  cr = cairo_create (surface);
+  cairo_set_source_rgb (cr, 1, 1, 1);
+  cairo_paint (cr);
+
+  cairo_set_font_size (cr, 13);
+  for (i = 0; i * 20 < height + 20; i++)
+    {
+      y = i * 20 - (frame * 3) % 20;
+      if (((i + frame * 3 / 20) % 2) == 0)
+	{
+	  cairo_set_source_rgb (cr, 0.93, 0.93, 0.96);
+	  cairo_rectangle (cr, 0, y, width, 20);
+	  cairo_fill (cr);
+	}
+      cairo_set_source_rgb (cr, 0, 0, 0);
+      cairo_move_to (cr, 8, y + 15);
+      g_snprintf (text, sizeof (text), "Row %d of a long list that scrolls", i + frame * 3 / 20);
+      cairo_show_text (cr, text);
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_flush (surface);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GError *error = NULL;
+  GOptionContext *context;
+  BroadwayServer *server;
+  cairo_surface_t *surface;
+  GThread *thread;
+  gint64 start, encode_time;
+  guint32 id;
+  int i;
+
+  context = g_option_context_new ("- benchmark the broadway daemon");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  server = broadway_server_new (NULL, port, &error);
+  if (server == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  id = broadway_server_new_window (server, 0, 0, width, height, FALSE);
+  broadway_server_window_show (server, id);
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24, width, height);
+
+  thread = g_thread_new ("client", client_thread, &client);
+
+  /* The initial resync ends with a flush */
+  while (!broadway_server_has_client (server))
+    g_main_context_iteration (NULL, TRUE);
+  wait_for_flushes (1);
+
+  encode_time = 0;
+  start = g_get_monotonic_time ();
+
+  for (i = 0; i < n_frames; i++)
+    {
+      gint64 frame_start;
+
+      paint_frame (surface, i);
+
+      frame_start = g_get_monotonic_time ();
+      broadway_server_window_update (server, id, surface, NULL);
+      broadway_server_flush (server);
+      encode_time += g_get_monotonic_time () - frame_start;
+
+      wait_for_flushes (i + 2);
+    }
+
+  g_print ("%d frames of %dx%d, %s%s\n", n_frames, width, height,
+	   png ? "png" : "tiles",
+	   client.deflate_accepted ? ", permessage-deflate" : "");
+  g_print ("  %.1f kB per frame on the wire, %.1f kB of commands\n",
+	   client.wire_bytes / 1024.0 / n_frames,
+	   client.payload_bytes / 1024.0 / n_frames);
+  g_print ("  %.2f ms per frame to encode and send, %.2f ms per frame until acked\n",
+	   encode_time / 1000.0 / n_frames,
+	   (g_get_monotonic_time () - start) / 1000.0 / n_frames);
+
+  cairo_surface_destroy (surface);
+
+  /* The client thread is still blocked reading, just exit */
+  g_thread_unref (thread);
+
+  return 0;
+}
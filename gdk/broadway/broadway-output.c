@@ -205,18 +205,662 @@ to_png_a (int w, int h, int byte_stride, guint8 *data)
 }
 #endif
 
+/************************************************************************
+ *                Tile encoding                                         *
+ ************************************************************************/
+
+/* Images are split into TILE_SIZE x TILE_SIZE tiles, in row-major
+ * order. A tile with a single color is sent as that color, everything
+ * else with a QOI-style byte code: runs of the previous pixel, a
+ * 64-entry table of recently seen pixels, small differences to the
+ * previous pixel, or the literal pixel. broadway.js decodes the same
+ * format, so any change here needs to be made there too.
+ */
+
+#define TILE_SIZE 64
+
+/* Images with fewer tile rows are encoded on the calling thread */
+#define MIN_PARALLEL_TILE_ROWS 4
+
+enum {
+  TILE_SOLID = 0,
+  TILE_QOI = 1,
+  TILE_CACHED = 2,
+  TILE_QOI_STORE = 3
+};
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xc0
+#define QOI_OP_RGB   0xfe
+#define QOI_OP_RGBA  0xff
+
+#define PIXEL_A(p) (((p) >> 24) & 0xff)
+#define PIXEL_R(p) (((p) >> 16) & 0xff)
+#define PIXEL_G(p) (((p) >> 8) & 0xff)
+#define PIXEL_B(p) (((p) >> 0) & 0xff)
+
+static inline guint
+qoi_hash (guint32 p)
+{
+  return (PIXEL_R (p) * 3 + PIXEL_G (p) * 5 + PIXEL_B (p) * 7 + PIXEL_A (p) * 11) % 64;
+}
+
+static void
+append_pixel (GString *buf, guint32 p, gboolean with_alpha)
+{
+  g_string_append_c (buf, PIXEL_R (p));
+  g_string_append_c (buf, PIXEL_G (p));
+  g_string_append_c (buf, PIXEL_B (p));
+  if (with_alpha)
+    g_string_append_c (buf, PIXEL_A (p));
+}
+
+/* alpha is or:ed into every pixel, to make RGB24 data opaque */
+static void
+encode_tile (GString *buf,
+	     guint8  *data,
+	     int      byte_stride,
+	     int      w,
+	     int      h,
+	     guint32  alpha)
+{
+  guint32 index[64] = { 0 };
+  guint32 *line;
+  guint32 p, prev;
+  gsize size_start;
+  guint32 len;
+  int x, y, run;
+
+  prev = *(guint32 *)data | alpha;
+  for (y = 0; y < h; y++)
+    {
+      line = (guint32 *)(data + y * byte_stride);
+      for (x = 0; x < w; x++)
+	{
+	  if ((line[x] | alpha) != prev)
+	    goto not_solid;
+	}
+    }
+
+  g_string_append_c (buf, TILE_SOLID);
+  append_pixel (buf, prev, TRUE);
+  return;
+
+ not_solid:
+  g_string_append_c (buf, TILE_QOI);
+  size_start = buf->len;
+  g_string_append_len (buf, "\0\0\0\0", 4);
+
+  prev = 0xff000000;
+  run = 0;
+
+  for (y = 0; y < h; y++)
+    {
+      line = (guint32 *)(data + y * byte_stride);
+      for (x = 0; x < w; x++)
+	{
+	  guint hash;
+
+	  p = line[x] | alpha;
+
+	  if (p == prev)
+	    {
+	      if (++run == 62)
+		{
+		  g_string_append_c (buf, QOI_OP_RUN | (run - 1));
+		  run = 0;
+		}
+	      continue;
+	    }
+
+	  if (run > 0)
+	    {
+	      g_string_append_c (buf, QOI_OP_RUN | (run - 1));
+	      run = 0;
+	    }
+
+	  hash = qoi_hash (p);
+	  if (index[hash] == p)
+	    g_string_append_c (buf, QOI_OP_INDEX | hash);
+	  else if (PIXEL_A (p) != PIXEL_A (prev))
+	    {
+	      g_string_append_c (buf, QOI_OP_RGBA);
+	      append_pixel (buf, p, TRUE);
+	    }
+	  else
+	    {
+	      gint8 vr, vg, vb, vg_r, vg_b;
+
+	      vr = PIXEL_R (p) - PIXEL_R (prev);
+	      vg = PIXEL_G (p) - PIXEL_G (prev);
+	      vb = PIXEL_B (p) - PIXEL_B (prev);
+	      vg_r = vr - vg;
+	      vg_b = vb - vg;
+
+	      if (vr > -3 && vr < 2 &&
+		  vg > -3 && vg < 2 &&
+		  vb > -3 && vb < 2)
+		g_string_append_c (buf, QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+	      else if (vg_r > -9 && vg_r < 8 &&
+		       vg > -33 && vg < 32 &&
+		       vg_b > -9 && vg_b < 8)
+		{
+		  g_string_append_c (buf, QOI_OP_LUMA | (vg + 32));
+		  g_string_append_c (buf, (vg_r + 8) << 4 | (vg_b + 8));
+		}
+	      else
+		{
+		  g_string_append_c (buf, QOI_OP_RGB);
+		  append_pixel (buf, p, FALSE);
+		}
+	    }
+
+	  index[hash] = p;
+	  prev = p;
+	}
+    }
+
+  if (run > 0)
+    g_string_append_c (buf, QOI_OP_RUN | (run - 1));
+
+  len = buf->len - size_start - 4;
+  buf->str[size_start + 0] = (len >> 0) & 0xff;
+  buf->str[size_start + 1] = (len >> 8) & 0xff;
+  buf->str[size_start + 2] = (len >> 16) & 0xff;
+  buf->str[size_start + 3] = (len >> 24) & 0xff;
+}
+
+/* Full tiles that aren't a single color are remembered by the hash of
+ * their content in a cache of TILE_CACHE_SIZE slots. The daemon picks
+ * the slot for each new tile and evicts the least recently used one,
+ * the client only stores tiles where it is told to, so both sides
+ * always agree on the content of every slot.
+ *
+ * The encoded data of every cached tile is kept as well. The encoding
+ * is lossless, so tiles with the same data have the same pixels, and
+ * comparing it makes sure a hash collision never makes the client
+ * draw the wrong tile.
+ */
+#define TILE_CACHE_SIZE 512
+
+typedef struct _TileCacheEntry TileCacheEntry;
+typedef struct _TileCache TileCache;
+
+struct _TileCacheEntry {
+  guint64 hash;
+  guint16 slot;
+  char   *data;
+  gsize   len;
+  GList   link;
+};
+
+struct _TileCache {
+  TileCacheEntry entries[TILE_CACHE_SIZE];
+  guint n_entries;
+  GHashTable *by_hash;
+  GQueue lru;
+};
+
+static TileCache *
+tile_cache_new (void)
+{
+  TileCache *cache;
+
+  cache = g_new0 (TileCache, 1);
+  cache->by_hash = g_hash_table_new (g_int64_hash, g_int64_equal);
+
+  return cache;
+}
+
+static void
+tile_cache_free (TileCache *cache)
+{
+  guint i;
+
+  for (i = 0; i < cache->n_entries; i++)
+    g_free (cache->entries[i].data);
+
+  g_hash_table_destroy (cache->by_hash);
+  g_free (cache);
+}
+
+/* Returns TRUE if the tile with the hash and encoded data is cached,
+ * otherwise stores it. Either way, *slot is set to the slot of the
+ * tile.
+ */
+static gboolean
+tile_cache_lookup (TileCache  *cache,
+		   guint64     hash,
+		   const char *data,
+		   gsize       len,
+		   guint16    *slot)
+{
+  TileCacheEntry *entry;
+
+  entry = g_hash_table_lookup (cache->by_hash, &hash);
+  if (entry != NULL)
+    {
+      g_queue_unlink (&cache->lru, &entry->link);
+      g_queue_push_head_link (&cache->lru, &entry->link);
+      *slot = entry->slot;
+
+      if (entry->len == len && memcmp (entry->data, data, len) == 0)
+	return TRUE;
+
+      /* A different tile with the same hash, replace it */
+      g_free (entry->data);
+      entry->data = g_memdup (data, len);
+      entry->len = len;
+      return FALSE;
+    }
+
+  if (cache->n_entries < TILE_CACHE_SIZE)
+    {
+      entry = &cache->entries[cache->n_entries];
+      entry->slot = cache->n_entries++;
+      entry->link.data = entry;
+    }
+  else
+    {
+      entry = g_queue_pop_tail_link (&cache->lru)->data;
+      g_hash_table_remove (cache->by_hash, &entry->hash);
+      g_free (entry->data);
+    }
+
+  entry->hash = hash;
+  entry->data = g_memdup (data, len);
+  entry->len = len;
+  g_hash_table_insert (cache->by_hash, &entry->hash, entry);
+  g_queue_push_head_link (&cache->lru, &entry->link);
+
+  *slot = entry->slot;
+  return FALSE;
+}
+
+/* FNV-1a over the pixels */
+static guint64
+hash_tile (guint8  *data,
+	   int      byte_stride,
+	   guint32  alpha)
+{
+  guint64 hash = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+  guint32 *line;
+  int x, y;
+
+  for (y = 0; y < TILE_SIZE; y++)
+    {
+      line = (guint32 *)(data + y * byte_stride);
+      for (x = 0; x < TILE_SIZE; x++)
+	{
+	  hash ^= line[x] | alpha;
+	  hash *= G_GUINT64_CONSTANT (0x100000001b3);
+	}
+    }
+
+  return hash;
+}
+
+typedef struct _TileJob TileJob;
+typedef struct _TileBand TileBand;
+typedef struct _TileInfo TileInfo;
+
+struct _TileJob {
+  guint8  *data;
+  int      w;
+  int      h;
+  int      byte_stride;
+  guint32  alpha;
+
+  GMutex   mutex;
+  GCond    cond;
+  guint    pending;
+};
+
+struct _TileInfo {
+  gsize    offset;
+  gsize    len;
+  guint64  hash;
+  gboolean cacheable;
+};
+
+struct _TileBand {
+  TileJob *job;
+  int      first_row;
+  int      last_row;
+  GString *buf;
+  GArray  *tiles;
+};
+
+static void
+encode_tile_band (TileBand *band)
+{
+  TileJob *job = band->job;
+  TileInfo info;
+  guint8 *data;
+  int tx, ty, tw, th;
+
+  for (ty = band->first_row * TILE_SIZE; ty < band->last_row * TILE_SIZE && ty < job->h; ty += TILE_SIZE)
+    {
+      th = MIN (TILE_SIZE, job->h - ty);
+      for (tx = 0; tx < job->w; tx += TILE_SIZE)
+	{
+	  tw = MIN (TILE_SIZE, job->w - tx);
+	  data = job->data + ty * job->byte_stride + tx * 4;
+
+	  info.offset = band->buf->len;
+	  encode_tile (band->buf, data, job->byte_stride, tw, th, job->alpha);
+	  info.len = band->buf->len - info.offset;
+
+	  info.cacheable = tw == TILE_SIZE && th == TILE_SIZE &&
+			   band->buf->str[info.offset] == TILE_QOI;
+	  info.hash = info.cacheable ? hash_tile (data, job->byte_stride, job->alpha) : 0;
+
+	  g_array_append_val (band->tiles, info);
+	}
+    }
+}
+
+static void
+encode_tile_band_thread_func (gpointer data,
+			      gpointer user_data)
+{
+  TileBand *band = data;
+  TileJob *job = band->job;
+
+  encode_tile_band (band);
+
+  g_mutex_lock (&job->mutex);
+  job->pending--;
+  if (job->pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+static GThreadPool *
+get_encode_pool (void)
+{
+  static GThreadPool *pool = NULL;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (encode_tile_band_thread_func,
+				    NULL,
+				    g_get_num_processors (),
+				    FALSE,
+				    NULL);
+
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  return pool;
+}
+
+/* Appends the tiles of the image to buf. Bands of tile rows are
+ * encoded in parallel into separate buffers, the last one on the
+ * calling thread. The bands are then concatenated in order, which is
+ * also when cacheable tiles are looked up in the tile cache, so the
+ * client sees the cache updates in the order they happened. Returns
+ * the number of tiles that were found in the cache.
+ */
+static guint
+to_tiles (GString *buf, TileCache *cache, int w, int h, int byte_stride, guint32 *data, guint32 alpha)
+{
+  TileJob job;
+  TileBand *bands;
+  guint n_bands, n_rows, i, j;
+  guint n_cached = 0;
+
+  job.data = (guint8 *)data;
+  job.w = w;
+  job.h = h;
+  job.byte_stride = byte_stride;
+  job.alpha = alpha;
+
+  n_rows = (h + TILE_SIZE - 1) / TILE_SIZE;
+  n_bands = 1;
+  if (n_rows >= MIN_PARALLEL_TILE_ROWS)
+    n_bands = MIN (n_rows, g_get_num_processors ());
+
+  bands = g_newa (TileBand, n_bands);
+  for (i = 0; i < n_bands; i++)
+    {
+      bands[i].job = &job;
+      bands[i].first_row = n_rows * i / n_bands;
+      bands[i].last_row = n_rows * (i + 1) / n_bands;
+      bands[i].buf = g_string_new (NULL);
+      bands[i].tiles = g_array_new (FALSE, FALSE, sizeof (TileInfo));
+    }
+
+  if (n_bands > 1)
+    {
+      g_mutex_init (&job.mutex);
+      g_cond_init (&job.cond);
+
+      job.pending = n_bands - 1;
+      for (i = 0; i + 1 < n_bands; i++)
+	g_thread_pool_push (get_encode_pool (), &bands[i], NULL);
+    }
+
+  encode_tile_band (&bands[n_bands - 1]);
+
+  if (n_bands > 1)
+    {
+      g_mutex_lock (&job.mutex);
+      while (job.pending > 0)
+	g_cond_wait (&job.cond, &job.mutex);
+      g_mutex_unlock (&job.mutex);
+
+      g_mutex_clear (&job.mutex);
+      g_cond_clear (&job.cond);
+    }
+
+  for (i = 0; i < n_bands; i++)
+    {
+      for (j = 0; j < bands[i].tiles->len; j++)
+	{
+	  TileInfo *info = &g_array_index (bands[i].tiles, TileInfo, j);
+	  const char *tile = bands[i].buf->str + info->offset;
+	  guint16 slot;
+
+	  if (!info->cacheable)
+	    {
+	      g_string_append_len (buf, tile, info->len);
+	      continue;
+	    }
+
+	  if (tile_cache_lookup (cache, info->hash, tile, info->len, &slot))
+	    {
+	      g_string_append_c (buf, TILE_CACHED);
+	      g_string_append_c (buf, slot & 0xff);
+	      g_string_append_c (buf, slot >> 8);
+	      n_cached++;
+	    }
+	  else
+	    {
+	      /* The QOI data, stored in the slot */
+	      g_string_append_c (buf, TILE_QOI_STORE);
+	      g_string_append_c (buf, slot & 0xff);
+	      g_string_append_c (buf, slot >> 8);
+	      g_string_append_len (buf, tile + 1, info->len - 1);
+	    }
+	}
+
+      g_string_free (bands[i].buf, TRUE);
+      g_array_free (bands[i].tiles, TRUE);
+    }
+
+  return n_cached;
+}
+
 /************************************************************************
  *                Basic I/O primitives                                  *
  ************************************************************************/
 
+/* The client acknowledges every surface flush it has handled. While
+ * more than this many flushes or bytes are not acknowledged, the
+ * client is considered to be behind. Clients that never sent an
+ * acknowledgement, like an old broadway.js from the browser cache,
+ * are never considered to be behind.
+ */
+#define MAX_FRAMES_IN_FLIGHT 8
+#define MAX_BYTES_IN_FLIGHT (512 * 1024)
+
+typedef struct {
+  guint32 serial;
+  guint64 total_bytes;
+} FrameMark;
+
+/* Smaller messages are not worth compressing */
+#define MIN_DEFLATE_SIZE 64
+
 struct BroadwayOutput {
-  GOutputStream *out;
+  GSocketConnection *connection;
+  GSocket *socket;
   GString *buf;
   int error;
   guint32 serial;
   gboolean proto_v7_plus;
   gboolean binary;
+  gboolean tiles;
+  TileCache *tile_cache;
+
+  /* Image data encoded since the last surface flush, only kept
+   * track of with BROADWAY_DEBUG=stats */
+  gboolean stats;
+  gsize frame_bytes;
+  gint64 frame_encode_time;
+  guint frame_cached_tiles;
+
+  /* Flow control */
+  gboolean got_ack;
+  guint64 bytes_written;
+  guint64 bytes_acked;
+  GQueue frames_in_flight;
+
+  /* permessage-deflate, with the context kept between messages */
+  gboolean deflate;
+  GConverter *compressor;
+  GConverter *decompressor;
+  GByteArray *deflate_buf;
+  GByteArray *inflate_buf;
+};
+
+#ifdef G_ENABLE_DEBUG
+static const GDebugKey broadway_debug_keys[] = {
+  { "stats", BROADWAY_DEBUG_STATS }
 };
+#endif
+
+guint
+broadway_get_debug_flags (void)
+{
+  static gsize initialized = 0;
+  static guint flags = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+#ifdef G_ENABLE_DEBUG
+      flags = g_parse_debug_string (g_getenv ("BROADWAY_DEBUG"),
+				    broadway_debug_keys,
+				    G_N_ELEMENTS (broadway_debug_keys));
+#endif
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return flags;
+}
+
+/* Writes all the vectors to the socket, header and payload in a single
+ * call without copying them together first.
+ */
+static void
+send_vectors (BroadwayOutput *output,
+	      GOutputVector  *vectors,
+	      int             n_vectors)
+{
+  gssize res;
+
+  while (n_vectors > 0)
+    {
+      res = g_socket_send_message (output->socket, NULL,
+				   vectors, n_vectors,
+				   NULL, 0, 0, NULL, NULL);
+      if (res < 0)
+	{
+	  output->error = TRUE;
+	  return;
+	}
+
+      while (n_vectors > 0 && (gsize)res >= vectors->size)
+	{
+	  res -= vectors->size;
+	  vectors++;
+	  n_vectors--;
+	}
+
+      if (n_vectors > 0)
+	{
+	  vectors->buffer = (const guint8 *)vectors->buffer + res;
+	  vectors->size -= res;
+	}
+    }
+}
+
+/* Runs data through the converter and appends the output to out. The
+ * converter is flushed, so all of the data comes out. Fails if out
+ * would grow beyond max_len bytes, unless max_len is 0.
+ */
+static gboolean
+convert_flush (GConverter   *converter,
+	       const guint8 *data,
+	       gsize         len,
+	       gsize         max_len,
+	       GByteArray   *out)
+{
+  GConverterResult res;
+  gsize bytes_read, bytes_written, avail, old_len;
+  GError *error = NULL;
+
+  do
+    {
+      old_len = out->len;
+      avail = MAX (2 * len, 1024);
+      if (max_len != 0)
+	{
+	  if (old_len >= max_len)
+	    return FALSE;
+	  avail = MIN (avail, max_len - old_len);
+	}
+      g_byte_array_set_size (out, old_len + avail);
+
+      res = g_converter_convert (converter,
+				 data, len,
+				 out->data + old_len, avail,
+				 G_CONVERTER_FLUSH,
+				 &bytes_read, &bytes_written,
+				 &error);
+      if (res == G_CONVERTER_ERROR)
+	{
+	  g_byte_array_set_size (out, old_len);
+	  g_warning ("permessage-deflate: %s", error->message);
+	  g_error_free (error);
+	  return FALSE;
+	}
+
+      g_byte_array_set_size (out, old_len + bytes_written);
+      data += bytes_read;
+      len -= bytes_read;
+    }
+  while (len > 0 || (bytes_written == avail && res != G_CONVERTER_FLUSHED));
+
+  return TRUE;
+}
+
+static const guint8 deflate_tail[4] = { 0x00, 0x00, 0xff, 0xff };
 
 static void
 broadway_output_send_cmd (BroadwayOutput *output,
@@ -224,14 +868,38 @@ broadway_output_send_cmd (BroadwayOutput *output,
 			  const void *buf, gsize count)
 {
   gboolean mask = FALSE;
+  gboolean compressed = FALSE;
+  gboolean mid_header, long_header;
   guchar header[16];
+  GOutputVector vectors[2];
   size_t p;
 
-  gboolean mid_header = count > 125 && count <= 65535;
-  gboolean long_header = count > 65535;
+  if (output->deflate && fin && count >= MIN_DEFLATE_SIZE &&
+      (code == BROADWAY_WS_TEXT || code == BROADWAY_WS_BINARY))
+    {
+      g_byte_array_set_size (output->deflate_buf, 0);
+      if (convert_flush (output->compressor, buf, count, 0, output->deflate_buf) &&
+	  output->deflate_buf->len >= 4 &&
+	  memcmp (output->deflate_buf->data + output->deflate_buf->len - 4, deflate_tail, 4) == 0)
+	{
+	  /* The flush marker is implied by the extension */
+	  buf = output->deflate_buf->data;
+	  count = output->deflate_buf->len - 4;
+	  compressed = TRUE;
+	}
+      else
+	{
+	  /* The peer's decompressor would be out of sync from now on */
+	  output->error = TRUE;
+	  return;
+	}
+    }
+
+  mid_header = count > 125 && count <= 65535;
+  long_header = count > 65535;
 
   /* NB. big-endian spec => bit 0 == MSB */
-  header[0] = ( (fin ? 0x80 : 0) | (code & 0x0f) );
+  header[0] = ( (fin ? 0x80 : 0) | (compressed ? 0x40 : 0) | (code & 0x0f) );
   header[1] = ( (mask ? 0x80 : 0) |
                 (mid_header ? 126 : long_header ? 127 : count) );
   p = 2;
@@ -246,18 +914,51 @@ broadway_output_send_cmd (BroadwayOutput *output,
       p += 8;
     }
   // FIXME: if we are paranoid we should 'mask' the data
-  // FIXME: we should really emit these as a single write
-  g_output_stream_write_all (output->out, header, p, NULL, NULL, NULL);
-  g_output_stream_write_all (output->out, buf, count, NULL, NULL, NULL);
+  vectors[0].buffer = header;
+  vectors[0].size = p;
+  vectors[1].buffer = buf;
+  vectors[1].size = count;
+  send_vectors (output, vectors, 2);
 }
 
 static void
 broadway_output_send_cmd_pre_v7 (BroadwayOutput *output,
 				 const void *buf, gsize count)
 {
-  g_output_stream_write_all (output->out, "\0", 1, NULL, NULL, NULL);
-  g_output_stream_write_all (output->out, buf, count, NULL, NULL, NULL);
-  g_output_stream_write_all (output->out, "\xff", 1, NULL, NULL, NULL);
+  GOutputVector vectors[3];
+
+  vectors[0].buffer = "\0";
+  vectors[0].size = 1;
+  vectors[1].buffer = buf;
+  vectors[1].size = count;
+  vectors[2].buffer = "\xff";
+  vectors[2].size = 1;
+  send_vectors (output, vectors, 3);
+}
+
+/* Decompresses a message the client sent with permessage-deflate.
+ * Returns the message, which is valid until the next call, and sets
+ * out_len to its length, or returns NULL if it could not be
+ * decompressed or would be longer than max_len bytes.
+ */
+const char *
+broadway_output_inflate (BroadwayOutput *output,
+			 const guint8   *data,
+			 gsize           len,
+			 gsize           max_len,
+			 gsize          *out_len)
+{
+  if (!output->deflate)
+    return NULL;
+
+  g_byte_array_set_size (output->inflate_buf, 0);
+  if (!convert_flush (output->decompressor, data, len, max_len, output->inflate_buf) ||
+      !convert_flush (output->decompressor, deflate_tail, 4, max_len, output->inflate_buf))
+    return NULL;
+
+  *out_len = output->inflate_buf->len;
+
+  return (const char *)output->inflate_buf->data;
 }
 
 void broadway_output_pong (BroadwayOutput *output)
@@ -281,25 +982,70 @@ broadway_output_flush (BroadwayOutput *output)
     broadway_output_send_cmd (output, TRUE, BROADWAY_WS_TEXT,
 			      output->buf->str, output->buf->len);
 
+  output->bytes_written += output->buf->len;
   g_string_set_size (output->buf, 0);
 
   return !output->error;
 
 }
 
+void
+broadway_output_ack (BroadwayOutput *output,
+		     guint32         serial)
+{
+  FrameMark *mark;
+
+  output->got_ack = TRUE;
+
+  while ((mark = g_queue_peek_head (&output->frames_in_flight)) != NULL &&
+	 (gint32)(mark->serial - serial) <= 0)
+    {
+      output->bytes_acked = mark->total_bytes;
+      g_slice_free (FrameMark, g_queue_pop_head (&output->frames_in_flight));
+    }
+}
+
+gboolean
+broadway_output_is_behind (BroadwayOutput *output)
+{
+  if (!output->got_ack)
+    return FALSE;
+
+  return
+    g_queue_get_length (&output->frames_in_flight) >= MAX_FRAMES_IN_FLIGHT ||
+    output->bytes_written + output->buf->len - output->bytes_acked >= MAX_BYTES_IN_FLIGHT;
+}
+
 BroadwayOutput *
-broadway_output_new (GOutputStream *out, guint32 serial,
-		     gboolean proto_v7_plus, gboolean binary)
+broadway_output_new (GSocketConnection *connection, guint32 serial,
+		     gboolean proto_v7_plus, gboolean binary,
+		     gboolean tiles, gboolean deflate)
 {
   BroadwayOutput *output;
 
   output = g_new0 (BroadwayOutput, 1);
 
-  output->out = g_object_ref (out);
+  output->connection = g_object_ref (connection);
+  output->socket = g_socket_connection_get_socket (connection);
   output->buf = g_string_new ("");
   output->serial = serial;
   output->proto_v7_plus = proto_v7_plus;
   output->binary = binary;
+  output->stats = (broadway_get_debug_flags () & BROADWAY_DEBUG_STATS) != 0;
+  /* The tile encoding is only defined for the binary protocol */
+  output->tiles = binary && tiles;
+  if (output->tiles)
+    output->tile_cache = tile_cache_new ();
+
+  /* Only negotiated for the v7+ protocol */
+  output->deflate = proto_v7_plus && deflate;
+  if (output->deflate)
+    {
+      output->compressor = G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1));
+      output->decompressor = G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+      output->deflate_buf = g_byte_array_new ();
+      output->inflate_buf = g_byte_array_new ();
+    }
 
   return output;
 }
@@ -307,7 +1053,18 @@ broadway_output_new (GOutputStream *out, guint32 serial,
 void
 broadway_output_free (BroadwayOutput *output)
 {
-  g_object_unref (output->out);
+  g_object_unref (output->connection);
+  if (output->deflate)
+    {
+      g_object_unref (output->compressor);
+      g_object_unref (output->decompressor);
+      g_byte_array_free (output->deflate_buf, TRUE);
+      g_byte_array_free (output->inflate_buf, TRUE);
+    }
+  while (!g_queue_is_empty (&output->frames_in_flight))
+    g_slice_free (FrameMark, g_queue_pop_head (&output->frames_in_flight));
+  if (output->tile_cache)
+    tile_cache_free (output->tile_cache);
   free (output);
 }
 
@@ -560,11 +1317,56 @@ broadway_output_set_transient_for (BroadwayOutput *output,
 }
 
 
+static void
+put_tiles (BroadwayOutput *output, int id, int x, int y,
+	   int w, int h, int byte_stride, void *data, guint32 alpha)
+{
+  gsize size_start, image_start, len;
+  guint n_cached;
+
+  write_header (output, BROADWAY_OP_PUT_TILES);
+
+  append_uint16 (output, id);
+  append_uint16 (output, x);
+  append_uint16 (output, y);
+  append_uint16 (output, w);
+  append_uint16 (output, h);
+
+  size_start = output->buf->len;
+  append_uint32 (output, 0);
+
+  image_start = output->buf->len;
+  n_cached = to_tiles (output->buf, output->tile_cache,
+		       w, h, byte_stride, (guint32*)data, alpha);
+  if (output->stats)
+    output->frame_cached_tiles += n_cached;
+
+  len = output->buf->len - image_start;
+
+  overwrite_uint32 (output, size_start, len);
+}
+
 void
 broadway_output_put_rgb (BroadwayOutput *output,  int id, int x, int y,
 			 int w, int h, int byte_stride, void *data)
 {
   gsize size_start, image_start, len;
+  gint64 start_time = 0;
+
+  if (output->stats)
+    start_time = g_get_monotonic_time ();
+
+  if (output->tiles)
+    {
+      image_start = output->buf->len;
+      put_tiles (output, id, x, y, w, h, byte_stride, data, 0xff000000);
+      if (output->stats)
+	{
+	  output->frame_bytes += output->buf->len - image_start;
+	  output->frame_encode_time += g_get_monotonic_time () - start_time;
+	}
+      return;
+    }
 
   write_header (output, BROADWAY_OP_PUT_RGB);
 
@@ -584,6 +1386,12 @@ broadway_output_put_rgb (BroadwayOutput *output,  int id, int x, int y,
   len = output->buf->len - image_start;
 
   overwrite_uint32 (output, size_start, len);
+
+  if (output->stats)
+    {
+      output->frame_bytes += len;
+      output->frame_encode_time += g_get_monotonic_time () - start_time;
+    }
 }
 
 typedef struct  {
@@ -816,6 +1624,10 @@ broadway_output_put_rgba (BroadwayOutput *output,  int id, int x, int y,
   BroadwayBox *rects;
   int i, n_rects;
   gsize size_start, image_start, len;
+  gint64 start_time = 0;
+
+  if (output->stats)
+    start_time = g_get_monotonic_time ();
 
   rects = rgba_find_rects (data, w, h, byte_stride, &n_rects);
 
@@ -823,6 +1635,18 @@ broadway_output_put_rgba (BroadwayOutput *output,  int id, int x, int y,
     {
       guint8 *subdata;
 
+      if (output->tiles)
+	{
+	  image_start = output->buf->len;
+	  subdata = (guint8 *)data + rects[i].x1 * 4 + rects[i].y1 * byte_stride;
+	  put_tiles (output, id, x + rects[i].x1, y + rects[i].y1,
+		     rects[i].x2 - rects[i].x1, rects[i].y2 - rects[i].y1,
+		     byte_stride, subdata, 0);
+	  if (output->stats)
+	    output->frame_bytes += output->buf->len - image_start;
+	  continue;
+	}
+
       write_header (output, BROADWAY_OP_PUT_RGB);
       append_uint16 (output, id);
       append_uint16 (output, x + rects[i].x1);
@@ -846,15 +1670,46 @@ broadway_output_put_rgba (BroadwayOutput *output,  int id, int x, int y,
       len = output->buf->len - image_start;
 
       overwrite_uint32 (output, size_start, len);
+
+      if (output->stats)
+	output->frame_bytes += len;
     }
 
   free (rects);
+
+  if (output->stats)
+    output->frame_encode_time += g_get_monotonic_time () - start_time;
 }
 
 void
 broadway_output_surface_flush (BroadwayOutput *output,
 			       int             id)
 {
+  FrameMark *mark;
+
+  mark = g_slice_new (FrameMark);
+  mark->serial = output->serial;
+
   write_header (output, BROADWAY_OP_FLUSH);
   append_uint16 (output, id);
+
+  mark->total_bytes = output->bytes_written + output->buf->len;
+  g_queue_push_tail (&output->frames_in_flight, mark);
+
+  /* Until the client acknowledges anything, only remember the last
+   * few flushes so the queue doesn't grow forever. An ack for an
+   * older flush than those just doesn't release anything */
+  if (!output->got_ack &&
+      g_queue_get_length (&output->frames_in_flight) > MAX_FRAMES_IN_FLIGHT)
+    g_slice_free (FrameMark, g_queue_pop_head (&output->frames_in_flight));
+
+  if (output->stats)
+    {
+      g_message ("surface %d: %" G_GSIZE_FORMAT " bytes of image data, encoded in %" G_GINT64_FORMAT " us, %u cached tiles",
+		 id, output->frame_bytes, output->frame_encode_time, output->frame_cached_tiles);
+
+      output->frame_bytes = 0;
+      output->frame_encode_time = 0;
+      output->frame_cached_tiles = 0;
+    }
 }
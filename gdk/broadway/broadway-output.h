@@ -16,13 +16,24 @@ typedef enum {
   BROADWAY_WS_CNX_PONG = 0xa
 } BroadwayWSOpCode;
 
-BroadwayOutput *broadway_output_new             (GOutputStream  *out,
+typedef enum {
+  BROADWAY_DEBUG_STATS = 1 << 0
+} BroadwayDebugFlag;
+
+guint           broadway_get_debug_flags        (void);
+
+BroadwayOutput *broadway_output_new             (GSocketConnection *connection,
 						 guint32         serial,
 						 gboolean        proto_v7_plus,
-						 gboolean        binary);
+						 gboolean        binary,
+						 gboolean        tiles,
+						 gboolean        deflate);
 void            broadway_output_free            (BroadwayOutput *output);
 int             broadway_output_flush           (BroadwayOutput *output);
 int             broadway_output_has_error       (BroadwayOutput *output);
+void            broadway_output_ack             (BroadwayOutput *output,
+						 guint32         serial);
+gboolean        broadway_output_is_behind       (BroadwayOutput *output);
 void            broadway_output_set_next_serial (BroadwayOutput *output,
 						 guint32         serial);
 guint32         broadway_output_get_next_serial (BroadwayOutput *output);
@@ -82,5 +93,10 @@ void            broadway_output_grab_pointer    (BroadwayOutput *output,
 						 gboolean owner_event);
 guint32         broadway_output_ungrab_pointer  (BroadwayOutput *output);
 void            broadway_output_pong            (BroadwayOutput *output);
+const char *    broadway_output_inflate         (BroadwayOutput *output,
+						 const guint8   *data,
+						 gsize           len,
+						 gsize           max_len,
+						 gsize          *out_len);
 
 #endif /* __BROADWAY_H__ */
@@ -21,7 +21,8 @@ typedef enum {
   BROADWAY_EVENT_UNGRAB_NOTIFY = 'u',
   BROADWAY_EVENT_CONFIGURE_NOTIFY = 'w',
   BROADWAY_EVENT_DELETE_NOTIFY = 'W',
-  BROADWAY_EVENT_SCREEN_SIZE_CHANGED = 'd'
+  BROADWAY_EVENT_SCREEN_SIZE_CHANGED = 'd',
+  BROADWAY_EVENT_FRAME_ACK = 'A'
 } BroadwayEventType;
 
 typedef enum {
@@ -35,6 +36,7 @@ typedef enum {
   BROADWAY_OP_MOVE_RESIZE = 'm',
   BROADWAY_OP_SET_TRANSIENT_FOR = 'p',
   BROADWAY_OP_PUT_RGB = 'i',
+  BROADWAY_OP_PUT_TILES = 't',
   BROADWAY_OP_FLUSH = 'f',
   BROADWAY_OP_REQUEST_AUTH = 'l',
   BROADWAY_OP_AUTH_OK = 'L',
@@ -166,6 +168,8 @@ typedef struct {
   char name[36];
   guint32 width;
   guint32 height;
+  guint32 n_rects;
+  BroadwayRect rects[1];
 } BroadwayRequestUpdate;
 
 typedef struct {
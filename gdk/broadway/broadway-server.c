@@ -99,12 +99,21 @@ struct BroadwayWindow {
   gint32 transient_for;
 
   cairo_surface_t *last_surface;
+  guint64 pixels_scanned;
+  guint64 pixels_changed;
+
+  /* Damage not sent while the client is behind, and a copy of
+   * what the app had drawn there at the time
+   */
+  cairo_region_t *pending_damage;
+  cairo_surface_t *pending_surface;
 
   char *cached_surface_name;
   cairo_surface_t *cached_surface;
 };
 
 static void broadway_server_resync_windows (BroadwayServer *server);
+static void broadway_server_send_pending_damage (BroadwayServer *server);
 
 G_DEFINE_TYPE (BroadwayServer, broadway_server, G_TYPE_OBJECT)
 
@@ -350,24 +359,44 @@ fake_configure_notify (BroadwayServer *server,
   process_input_message (server, &ev);
 }
 
-static char *
-parse_pointer_data (char *p, BroadwayInputPointerMsg *data)
+/* Parses a decimal number and skips the separator after it. Messages
+ * are parsed where they were received, so they are not nul-terminated
+ * and p must never go past end.
+ */
+static gint64
+parse_int (const char **p, const char *end)
 {
-  data->mouse_window_id = strtol (p, &p, 10);
-  p++; /* Skip , */
-  data->event_window_id = strtol (p, &p, 10);
-  p++; /* Skip , */
-  data->root_x = strtol (p, &p, 10);
-  p++; /* Skip , */
-  data->root_y = strtol (p, &p, 10);
-  p++; /* Skip , */
-  data->win_x = strtol (p, &p, 10);
-  p++; /* Skip , */
-  data->win_y = strtol (p, &p, 10);
-  p++; /* Skip , */
-  data->state = strtol (p, &p, 10);
+  const char *q = *p;
+  gboolean negative = FALSE;
+  guint64 value = 0;
 
-  return p;
+  if (q < end && *q == '-')
+    {
+      negative = TRUE;
+      q++;
+    }
+
+  while (q < end && g_ascii_isdigit (*q))
+    value = value * 10 + (*q++ - '0');
+
+  if (q < end)
+    q++; /* Skip , */
+
+  *p = q;
+
+  return negative ? -(gint64) value : (gint64) value;
+}
+
+static void
+parse_pointer_data (const char **p, const char *end, BroadwayInputPointerMsg *data)
+{
+  data->mouse_window_id = parse_int (p, end);
+  data->event_window_id = parse_int (p, end);
+  data->root_x = parse_int (p, end);
+  data->root_y = parse_int (p, end);
+  data->win_x = parse_int (p, end);
+  data->win_y = parse_int (p, end);
+  data->state = parse_int (p, end);
 }
 
 static void
@@ -388,19 +417,32 @@ verify_password (BroadwayServer *server, const char *password)
 }
 
 static void
-parse_input_message (BroadwayInput *input, const char *message)
+parse_input_message (BroadwayInput *input, const char *message, gsize len)
 {
   BroadwayServer *server = input->server;
   BroadwayInputMsg msg;
-  char *p;
+  const char *p, *end;
   gint64 time_;
 
+  if (len == 0)
+    return;
+
   if (!input->active)
     {
+      char *password;
+      gboolean ok;
+
       /* The input has not been activated yet, handle auth/start */
 
-      if (message[0] != 'l' ||
-	  !verify_password (server, message+1))
+      ok = FALSE;
+      if (message[0] == 'l')
+	{
+	  password = g_strndup (message + 1, len - 1);
+	  ok = verify_password (server, password);
+	  g_free (password);
+	}
+
+      if (!ok)
 	{
 	  broadway_output_request_auth (input->output);
 	  broadway_output_flush (input->output);
@@ -413,12 +455,11 @@ parse_input_message (BroadwayInput *input, const char *message)
 
   memset (&msg, 0, sizeof (msg));
 
-  p = (char *)message;
+  p = message;
+  end = message + len;
   msg.base.type = *p++;
-  msg.base.serial = (guint32)strtol (p, &p, 10);
-  p++; /* Skip , */
-  time_ = strtol(p, &p, 10);
-  p++; /* Skip , */
+  msg.base.serial = (guint32) parse_int (&p, end);
+  time_ = parse_int (&p, end);
 
   if (time_ == 0) {
     time_ = server->last_seen_time;
@@ -437,73 +478,74 @@ parse_input_message (BroadwayInput *input, const char *message)
 
   msg.base.time = time_;
 
+  /* Acks are for the daemon only */
+  if (msg.base.type == BROADWAY_EVENT_FRAME_ACK)
+    {
+      if (server->output == input->output)
+	{
+	  broadway_output_ack (server->output, msg.base.serial);
+	  broadway_server_send_pending_damage (server);
+	}
+      return;
+    }
+
   switch (msg.base.type) {
   case BROADWAY_EVENT_ENTER:
   case BROADWAY_EVENT_LEAVE:
-    p = parse_pointer_data (p, &msg.pointer);
+    parse_pointer_data (&p, end, &msg.pointer);
     update_future_pointer_info (server, &msg.pointer);
-    p++; /* Skip , */
-    msg.crossing.mode = strtol(p, &p, 10);
+    msg.crossing.mode = parse_int (&p, end);
     break;
 
   case BROADWAY_EVENT_POINTER_MOVE: /* Mouse move */
-    p = parse_pointer_data (p, &msg.pointer);
+    parse_pointer_data (&p, end, &msg.pointer);
     update_future_pointer_info (server, &msg.pointer);
     break;
 
   case BROADWAY_EVENT_BUTTON_PRESS:
   case BROADWAY_EVENT_BUTTON_RELEASE:
-    p = parse_pointer_data (p, &msg.pointer);
+    parse_pointer_data (&p, end, &msg.pointer);
     update_future_pointer_info (server, &msg.pointer);
-    p++; /* Skip , */
-    msg.button.button = strtol(p, &p, 10);
+    msg.button.button = parse_int (&p, end);
     break;
 
   case BROADWAY_EVENT_SCROLL:
-    p = parse_pointer_data (p, &msg.pointer);
+    parse_pointer_data (&p, end, &msg.pointer);
     update_future_pointer_info (server, &msg.pointer);
-    p++; /* Skip , */
-    msg.scroll.dir = strtol(p, &p, 10);
+    msg.scroll.dir = parse_int (&p, end);
     break;
 
   case BROADWAY_EVENT_KEY_PRESS:
   case BROADWAY_EVENT_KEY_RELEASE:
-    msg.key.mouse_window_id = strtol(p, &p, 10);
-    p++; /* Skip , */
-    msg.key.key = strtol(p, &p, 10);
-    p++; /* Skip , */
-    msg.key.state = strtol(p, &p, 10);
+    msg.key.mouse_window_id = parse_int (&p, end);
+    msg.key.key = parse_int (&p, end);
+    msg.key.state = parse_int (&p, end);
     break;
 
   case BROADWAY_EVENT_GRAB_NOTIFY:
   case BROADWAY_EVENT_UNGRAB_NOTIFY:
-    msg.grab_reply.res = strtol(p, &p, 10);
+    msg.grab_reply.res = parse_int (&p, end);
     break;
 
   case BROADWAY_EVENT_CONFIGURE_NOTIFY:
-    msg.configure_notify.id = strtol(p, &p, 10);
-    p++; /* Skip , */
-    msg.configure_notify.x = strtol (p, &p, 10);
-    p++; /* Skip , */
-    msg.configure_notify.y = strtol (p, &p, 10);
-    p++; /* Skip , */
-    msg.configure_notify.width = strtol (p, &p, 10);
-    p++; /* Skip , */
-    msg.configure_notify.height = strtol (p, &p, 10);
+    msg.configure_notify.id = parse_int (&p, end);
+    msg.configure_notify.x = parse_int (&p, end);
+    msg.configure_notify.y = parse_int (&p, end);
+    msg.configure_notify.width = parse_int (&p, end);
+    msg.configure_notify.height = parse_int (&p, end);
     break;
 
   case BROADWAY_EVENT_DELETE_NOTIFY:
-    msg.delete_notify.id = strtol(p, &p, 10);
+    msg.delete_notify.id = parse_int (&p, end);
     break;
 
   case BROADWAY_EVENT_SCREEN_SIZE_CHANGED:
-    msg.screen_resize_notify.width = strtol (p, &p, 10);
-    p++; /* Skip , */
-    msg.screen_resize_notify.height = strtol (p, &p, 10);
+    msg.screen_resize_notify.width = parse_int (&p, end);
+    msg.screen_resize_notify.height = parse_int (&p, end);
     break;
 
   default:
-    g_printerr ("parse_input_message - Unknown input command %c (%s)\n", msg.base.type, message);
+    g_printerr ("parse_input_message - Unknown input command %c (%.*s)\n", msg.base.type, (int) len, message);
     break;
   }
 
@@ -540,6 +582,10 @@ hex_dump (guchar *data, gsize len)
 #endif
 }
 
+/* Input messages are just a few numbers, anything larger than this is
+ * bogus and the client gets disconnected */
+#define MAX_INPUT_MESSAGE_SIZE (64 * 1024)
+
 static void
 parse_input (BroadwayInput *input)
 {
@@ -550,39 +596,47 @@ parse_input (BroadwayInput *input)
 
   if (input->proto_v7_plus)
     {
+      guchar *buf, *end;
+      gsize len;
+
       hex_dump (input->buffer->data, input->buffer->len);
 
-      while (input->buffer->len > 2)
+      /* Frames are parsed in place; the consumed ones are removed from
+       * the buffer once at the end. */
+      buf = input->buffer->data;
+      end = buf + input->buffer->len;
+
+      while (end - buf > 2)
 	{
-	  gsize len, payload_len;
+	  gsize payload_len;
 	  BroadwayWSOpCode code;
-	  gboolean is_mask, fin;
-	  guchar *buf, *data, *mask;
+	  gboolean is_mask, fin, compressed;
+	  guchar *data, *mask;
 
-	  buf = input->buffer->data;
-	  len = input->buffer->len;
+	  len = end - buf;
 
 #ifdef DEBUG_WEBSOCKETS
 	  g_print ("Parse input first byte 0x%2x 0x%2x\n", buf[0], buf[1]);
 #endif
 
 	  fin = buf[0] & 0x80;
+	  compressed = buf[0] & 0x40;
 	  code = buf[0] & 0x0f;
 	  payload_len = buf[1] & 0x7f;
 	  is_mask = buf[1] & 0x80;
 	  data = buf + 2;
 
-	  if (payload_len > 125)
+	  if (payload_len == 126)
 	    {
 	      if (len < 4)
-		return;
+		break;
 	      payload_len = GUINT16_FROM_BE( *(guint16 *) data );
 	      data += 2;
 	    }
-	  else if (payload_len > 126)
+	  else if (payload_len == 127)
 	    {
 	      if (len < 10)
-		return;
+		break;
 	      payload_len = GUINT64_FROM_BE( *(guint64 *) data );
 	      data += 8;
 	    }
@@ -591,13 +645,22 @@ parse_input (BroadwayInput *input)
 	  if (is_mask)
 	    {
 	      if (data - buf + 4 > len)
-		return;
+		break;
 	      mask = data;
 	      data += 4;
 	    }
 
-	  if (data - buf + payload_len > len)
-	    return; /* wait to accumulate more */
+	  if (payload_len > MAX_INPUT_MESSAGE_SIZE)
+	    {
+	      g_warning ("input message too large, closing connection");
+	      if (server->input == input)
+		server->input = NULL;
+	      broadway_input_free (input);
+	      return;
+	    }
+
+	  if (payload_len > len - (data - buf))
+	    break; /* wait to accumulate more */
 
 	  if (is_mask)
 	    {
@@ -616,12 +679,25 @@ parse_input (BroadwayInput *input)
 		g_warning ("can't yet accept fragmented input");
 #endif
 	      }
-	    else
+	    else if (compressed)
 	      {
-		char *terminated = g_strndup((char *)data, payload_len);
-	        parse_input_message (input, terminated);
-		g_free (terminated);
+		const char *message;
+		gsize message_len;
+
+		message = broadway_output_inflate (input->output, data, payload_len,
+						   MAX_INPUT_MESSAGE_SIZE, &message_len);
+		if (message == NULL)
+		  {
+		    g_warning ("can't inflate input message, closing connection");
+		    if (server->input == input)
+		      server->input = NULL;
+		    broadway_input_free (input);
+		    return;
+		  }
+		parse_input_message (input, message, message_len);
 	      }
+	    else
+	      parse_input_message (input, (const char *)data, payload_len);
 	    break;
 	  case BROADWAY_WS_CNX_PING:
 	    broadway_output_pong (input->output);
@@ -637,8 +713,10 @@ parse_input (BroadwayInput *input)
 	    }
 	  }
 
-	  g_byte_array_remove_range (input->buffer, 0, data - buf + payload_len);
+	  buf = data + payload_len;
 	}
+
+      g_byte_array_remove_range (input->buffer, 0, buf - input->buffer->data);
     }
   else /* old style protocol */
     {
@@ -658,11 +736,9 @@ parse_input (BroadwayInput *input)
 
       while ((ptr = memchr (buf, 0xff, len)) != NULL)
 	{
-	  *ptr = 0;
+	  parse_input_message (input, buf + 1, ptr - (buf + 1));
 	  ptr++;
 
-	  parse_input_message (input, buf + 1);
-
 	  len -= ptr - buf;
 	  buf = ptr;
 
@@ -849,6 +925,8 @@ broadway_server_block_for_input (BroadwayServer *server, char op,
     g_byte_array_append (input->buffer, buffer, res);
 
     parse_input (input);
+    if (server->input != input)
+      return NULL;
 
     /* Since we're parsing input but not processing the resulting messages
        we might not get a readable callback on the stream, so queue an idle to
@@ -920,7 +998,7 @@ generate_handshake_response_wsietf_v7 (const gchar *key)
 }
 
 static void
-start_input (HttpRequest *request, gboolean binary)
+start_input (HttpRequest *request, gboolean binary, gboolean tiles)
 {
   char **lines;
   char *p;
@@ -939,6 +1017,7 @@ start_input (HttpRequest *request, gboolean binary)
   GInputStream *in;
   char *key_v7;
   gboolean proto_v7_plus;
+  gboolean deflate;
   GSocket *socket;
   int flag = 1;
 
@@ -954,6 +1033,7 @@ start_input (HttpRequest *request, gboolean binary)
   key_v7 = NULL;
   origin = NULL;
   host = NULL;
+  deflate = FALSE;
   for (i = 0; lines[i] != NULL; i++)
     {
       if ((p = parse_line (lines[i], "Sec-WebSocket-Key1")))
@@ -1002,6 +1082,15 @@ start_input (HttpRequest *request, gboolean binary)
 	{
 	  origin = p;
 	}
+      else if ((p = parse_line (lines[i], "Sec-WebSocket-Extensions")))
+	{
+	  /* We always compress with a full window and keep the context,
+	   * so don't accept offers that ask for anything else */
+	  deflate =
+	    strstr (p, "permessage-deflate") != NULL &&
+	    strstr (p, "server_max_window_bits") == NULL &&
+	    strstr (p, "server_no_context_takeover") == NULL;
+	}
     }
 
   if (host == NULL)
@@ -1019,10 +1108,12 @@ start_input (HttpRequest *request, gboolean binary)
 			     "Connection: Upgrade\r\n"
 			     "Sec-WebSocket-Accept: %s\r\n"
 			     "%s%s%s"
+			     "%s"
 			     "Sec-WebSocket-Location: ws://%s/socket\r\n"
 			     "Sec-WebSocket-Protocol: broadway\r\n"
 			     "\r\n", accept,
 			     origin?"Sec-WebSocket-Origin: ":"", origin?origin:"", origin?"\r\n":"",
+			     deflate?"Sec-WebSocket-Extensions: permessage-deflate\r\n":"",
 			     host);
       g_free (accept);
 
@@ -1085,6 +1176,7 @@ start_input (HttpRequest *request, gboolean binary)
       g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (request->connection)),
 				 challenge, 16, NULL, NULL, NULL);
       proto_v7_plus = FALSE;
+      deflate = FALSE;
     }
 
   socket = g_socket_connection_get_socket (request->connection);
@@ -1102,8 +1194,8 @@ start_input (HttpRequest *request, gboolean binary)
   g_byte_array_append (input->buffer, data_buffer, data_buffer_size);
 
   input->output =
-    broadway_output_new (g_io_stream_get_output_stream (G_IO_STREAM (request->connection)),
-			 0, proto_v7_plus, binary);
+    broadway_output_new (request->connection,
+			 0, proto_v7_plus, binary, tiles, deflate);
 
   /* This will free and close the data input stream, but we got all the buffered content already */
   http_request_free (request);
@@ -1234,9 +1326,11 @@ got_request (HttpRequest *request)
   else if (strcmp (escaped, "/broadway.js") == 0)
     send_data (request, "text/javascript", broadway_js, G_N_ELEMENTS(broadway_js) - 1);
   else if (strcmp (escaped, "/socket") == 0)
-    start_input (request, FALSE);
+    start_input (request, FALSE, FALSE);
   else if (strcmp (escaped, "/socket-bin") == 0)
-    start_input (request, TRUE);
+    start_input (request, TRUE, FALSE);
+  else if (strcmp (escaped, "/socket-tiles") == 0)
+    start_input (request, TRUE, TRUE);
   else
     send_error (request, 404, "File not found");
 
@@ -1424,6 +1518,16 @@ broadway_server_destroy_window (BroadwayServer *server,
 	g_free (window->cached_surface_name);
       if (window->cached_surface != NULL)
 	cairo_surface_destroy (window->cached_surface);
+      if (window->last_surface != NULL)
+	cairo_surface_destroy (window->last_surface);
+      if (window->pending_damage != NULL)
+	cairo_region_destroy (window->pending_damage);
+      if (window->pending_surface != NULL)
+	cairo_surface_destroy (window->pending_surface);
+
+      if (broadway_get_debug_flags () & BROADWAY_DEBUG_STATS)
+	g_message ("window %d: %" G_GUINT64_FORMAT " pixels scanned, %" G_GUINT64_FORMAT " changed",
+		   window->id, window->pixels_scanned, window->pixels_changed);
 
       g_free (window);
     }
@@ -1600,35 +1704,41 @@ broadway_server_window_translate (BroadwayServer *server,
   return sent;
 }
 
-static void
-diff_surfaces (cairo_surface_t *surface,
-	       cairo_surface_t *old_surface)
+/* Turns the pixels of old_surface inside rect into the difference
+ * to surface: unchanged pixels become fully transparent, changed ones
+ * opaque. Returns the number of changed pixels.
+ */
+static guint
+diff_surfaces (cairo_surface_t       *surface,
+	       cairo_surface_t       *old_surface,
+	       cairo_rectangle_int_t *rect)
 {
   guint8 *data, *old_data;
   guint32 *line, *old_line;
-  int w, h, stride, old_stride;
+  int stride, old_stride;
   int x, y;
-
-  data = cairo_image_surface_get_data (surface);
-  old_data = cairo_image_surface_get_data (old_surface);
-
-  w = cairo_image_surface_get_width (surface);
-  h = cairo_image_surface_get_height (surface);
+  guint changed = 0;
 
   stride = cairo_image_surface_get_stride (surface);
   old_stride = cairo_image_surface_get_stride (old_surface);
 
-  for (y = 0; y < h; y++)
+  data = cairo_image_surface_get_data (surface) + rect->y * stride + rect->x * 4;
+  old_data = cairo_image_surface_get_data (old_surface) + rect->y * old_stride + rect->x * 4;
+
+  for (y = 0; y < rect->height; y++)
     {
       line = (guint32 *)data;
       old_line = (guint32 *)old_data;
 
-      for (x = 0; x < w; x++)
+      for (x = 0; x < rect->width; x++)
 	{
 	  if ((*line & 0xffffff) == (*old_line & 0xffffff))
 	    *old_line = 0;
 	  else
-	    *old_line = *line | 0xff000000;
+	    {
+	      *old_line = *line | 0xff000000;
+	      changed++;
+	    }
 	  line ++;
 	  old_line ++;
 	}
@@ -1636,15 +1746,26 @@ diff_surfaces (cairo_surface_t *surface,
       data += stride;
       old_data += old_stride;
     }
+
+  return changed;
 }
 
+/* Only the damaged part of the surface, as reported by the client, may
+ * differ from last_surface. If the client doesn't know, everything may
+ * have changed.
+ */
 void
 broadway_server_window_update (BroadwayServer *server,
 			       gint id,
-			       cairo_surface_t *surface)
+			       cairo_surface_t *surface,
+			       cairo_region_t *damage)
 {
   cairo_t *cr;
   BroadwayWindow *window;
+  cairo_rectangle_int_t rect;
+  cairo_region_t *area;
+  int i, n_rects, stride;
+  guint8 *data;
 
   if (surface == NULL)
     return;
@@ -1664,17 +1785,105 @@ broadway_server_window_update (BroadwayServer *server,
   g_assert (window->height == cairo_image_surface_get_height (window->last_surface));
   g_assert (window->height == cairo_image_surface_get_height (surface));
 
+  rect.x = 0;
+  rect.y = 0;
+  rect.width = window->width;
+  rect.height = window->height;
+
+  if (damage != NULL)
+    {
+      area = cairo_region_copy (damage);
+      cairo_region_intersect_rectangle (area, &rect);
+    }
+  else
+    area = cairo_region_create_rectangle (&rect);
+
+  /* While the client is behind, remember the damage instead of queuing
+   * more frames; it is sent once the client caught up. last_surface
+   * keeps what the client has, so the diff is still right then. The
+   * app may be drawing into the shared surface again by then, so copy
+   * the damaged pixels now.
+   */
+  if (server->output != NULL &&
+      window->last_synced &&
+      broadway_output_is_behind (server->output))
+    {
+      /* Resized since the copy was taken, start over with all of it */
+      if (window->pending_surface != NULL &&
+	  (cairo_image_surface_get_width (window->pending_surface) != window->width ||
+	   cairo_image_surface_get_height (window->pending_surface) != window->height))
+	{
+	  cairo_surface_destroy (window->pending_surface);
+	  window->pending_surface = NULL;
+	  cairo_region_union_rectangle (area, &rect);
+	}
+
+      if (window->pending_damage == NULL)
+	window->pending_damage = cairo_region_create ();
+      cairo_region_union (window->pending_damage, area);
+
+      if (window->pending_surface == NULL)
+	window->pending_surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24,
+							      window->width,
+							      window->height);
+      cr = cairo_create (window->pending_surface);
+      n_rects = cairo_region_num_rectangles (area);
+      for (i = 0; i < n_rects; i++)
+	{
+	  cairo_region_get_rectangle (area, i, &rect);
+	  cairo_rectangle (cr, rect.x, rect.y, rect.width, rect.height);
+	}
+      cairo_clip (cr);
+      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+      cairo_set_source_surface (cr, surface, 0, 0);
+      cairo_paint (cr);
+      cairo_destroy (cr);
+
+      cairo_region_destroy (area);
+      return;
+    }
+
+  /* surface is newer than the copy taken while deferring */
+  if (window->pending_damage != NULL)
+    {
+      cairo_region_union (area, window->pending_damage);
+      cairo_region_destroy (window->pending_damage);
+      window->pending_damage = NULL;
+    }
+  if (window->pending_surface != NULL)
+    {
+      cairo_surface_destroy (window->pending_surface);
+      window->pending_surface = NULL;
+    }
+
+  if (cairo_region_is_empty (area))
+    {
+      cairo_region_destroy (area);
+      return;
+    }
+
   if (server->output != NULL)
     {
       if (window->last_synced)
 	{
-	  diff_surfaces (surface,
-			 window->last_surface);
-	  broadway_output_put_rgba (server->output, window->id, 0, 0,
-				    cairo_image_surface_get_width (window->last_surface),
-				    cairo_image_surface_get_height (window->last_surface),
-				    cairo_image_surface_get_stride (window->last_surface),
-				    cairo_image_surface_get_data (window->last_surface));
+	  data = cairo_image_surface_get_data (window->last_surface);
+	  stride = cairo_image_surface_get_stride (window->last_surface);
+
+	  n_rects = cairo_region_num_rectangles (area);
+	  for (i = 0; i < n_rects; i++)
+	    {
+	      cairo_region_get_rectangle (area, i, &rect);
+
+	      window->pixels_scanned += rect.width * rect.height;
+	      window->pixels_changed += diff_surfaces (surface,
+						       window->last_surface,
+						       &rect);
+	      broadway_output_put_rgba (server->output, window->id,
+					rect.x, rect.y,
+					rect.width, rect.height,
+					stride,
+					data + rect.y * stride + rect.x * 4);
+	    }
 	}
       else
 	{
@@ -1684,16 +1893,73 @@ broadway_server_window_update (BroadwayServer *server,
 				   cairo_image_surface_get_height (surface),
 				   cairo_image_surface_get_stride (surface),
 				   cairo_image_surface_get_data (surface));
+
+	  rect.x = 0;
+	  rect.y = 0;
+	  rect.width = window->width;
+	  rect.height = window->height;
+	  cairo_region_union_rectangle (area, &rect);
 	}
 
       broadway_output_surface_flush (server->output, window->id);
     }
 
+  cairo_surface_mark_dirty (window->last_surface);
+
   cr = cairo_create (window->last_surface);
+  n_rects = cairo_region_num_rectangles (area);
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_region_get_rectangle (area, i, &rect);
+      cairo_rectangle (cr, rect.x, rect.y, rect.width, rect.height);
+    }
+  cairo_clip (cr);
   cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
   cairo_set_source_surface (cr, surface, 0, 0);
   cairo_paint (cr);
   cairo_destroy (cr);
+
+  cairo_region_destroy (area);
+}
+
+static void
+broadway_server_send_pending_damage (BroadwayServer *server)
+{
+  BroadwayWindow *window;
+  cairo_region_t *damage;
+  cairo_surface_t *surface;
+  gboolean sent = FALSE;
+  GList *l;
+
+  for (l = server->toplevels; l != NULL; l = l->next)
+    {
+      window = l->data;
+
+      if (server->output == NULL ||
+	  broadway_output_is_behind (server->output))
+	break;
+
+      if (window->pending_damage == NULL)
+	continue;
+
+      /* After a resize the new surface comes with its own update */
+      if (window->pending_surface == NULL ||
+	  cairo_image_surface_get_width (window->pending_surface) != window->width ||
+	  cairo_image_surface_get_height (window->pending_surface) != window->height)
+	continue;
+
+      damage = window->pending_damage;
+      surface = window->pending_surface;
+      window->pending_damage = NULL;
+      window->pending_surface = NULL;
+      broadway_server_window_update (server, window->id, surface, damage);
+      cairo_region_destroy (damage);
+      cairo_surface_destroy (surface);
+      sent = TRUE;
+    }
+
+  if (sent)
+    broadway_server_flush (server);
 }
 
 gboolean
@@ -70,7 +70,8 @@ cairo_surface_t   * broadway_server_create_surface           (int
 							      int               height);
 void                broadway_server_window_update            (BroadwayServer   *server,
 							      gint              id,
-							      cairo_surface_t  *surface);
+							      cairo_surface_t  *surface,
+							      cairo_region_t   *damage);
 gboolean            broadway_server_window_move_resize       (BroadwayServer   *server,
 							      gint              id,
 							      gboolean          with_move,
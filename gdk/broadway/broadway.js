@@ -598,6 +598,18 @@ function handleCommands(cmd)
 	    cmd.free_image_url (url);
 	    break;
 
+	case 't': // Put tiles
+	    q = new Object();
+	    q.op = 'i';
+	    q.id = cmd.get_16();
+	    q.x = cmd.get_16();
+	    q.y = cmd.get_16();
+	    w = cmd.get_16();
+	    h = cmd.get_16();
+	    q.img = cmd.get_tiles(w, h);
+	    surfaces[q.id].drawQueue.push(q);
+	    break;
+
 	case 'b': // Copy rects
 	    q = new Object();
 	    q.op = 'b';
@@ -623,6 +635,7 @@ function handleCommands(cmd)
 	    id = cmd.get_16();
 
 	    cmdFlushSurface(id);
+	    sendInput ("A", []);
 	    break;
 
 	case 'g': // Grab
@@ -745,6 +758,150 @@ BinCommands.prototype.get_image_url = function() {
 BinCommands.prototype.free_image_url = function(url) {
     URL.revokeObjectURL(url);
 };
+BinCommands.prototype.get_tiles = function(w, h) {
+    var size = this.get_32();
+    var canvas = document.createElement("canvas");
+    canvas.width = w;
+    canvas.height = h;
+    var context = canvas.getContext("2d");
+    var image = context.createImageData(w, h);
+    decodeTiles(this.u8, this.pos, w, h, image.data);
+    context.putImageData(image, 0, 0);
+    this.pos = this.pos + size;
+    return canvas;
+};
+
+/* Must match the tile encoding in broadway-output.c */
+var TILE_SIZE = 64;
+var tileIndex = new Uint32Array(64);
+var tileCache = [];
+
+function decodeQoiTile(u8, pos, end, pixels, w, tx, ty, tw, th)
+{
+    var index = tileIndex;
+    var run = 0;
+    var r = 0, g = 0, b = 0, a = 255;
+    var x, y, o;
+
+    for (var i = 0; i < 64; i++)
+	index[i] = 0;
+
+    for (y = 0; y < th; y++) {
+	o = ((ty + y) * w + tx) * 4;
+	for (x = 0; x < tw; x++) {
+	    if (run > 0) {
+		run--;
+	    } else if (pos < end) {
+		var b1 = u8[pos++];
+		if (b1 == 0xfe) { // RGB
+		    r = u8[pos++];
+		    g = u8[pos++];
+		    b = u8[pos++];
+		} else if (b1 == 0xff) { // RGBA
+		    r = u8[pos++];
+		    g = u8[pos++];
+		    b = u8[pos++];
+		    a = u8[pos++];
+		} else if ((b1 & 0xc0) == 0x00) { // Index
+		    var p = index[b1];
+		    r = (p >>> 16) & 0xff;
+		    g = (p >>> 8) & 0xff;
+		    b = p & 0xff;
+		    a = p >>> 24;
+		} else if ((b1 & 0xc0) == 0x40) { // Diff
+		    r = (r + ((b1 >> 4) & 0x03) - 2) & 0xff;
+		    g = (g + ((b1 >> 2) & 0x03) - 2) & 0xff;
+		    b = (b + (b1 & 0x03) - 2) & 0xff;
+		} else if ((b1 & 0xc0) == 0x80) { // Luma
+		    var b2 = u8[pos++];
+		    var vg = (b1 & 0x3f) - 32;
+		    r = (r + vg - 8 + ((b2 >> 4) & 0x0f)) & 0xff;
+		    g = (g + vg) & 0xff;
+		    b = (b + vg - 8 + (b2 & 0x0f)) & 0xff;
+		} else { // Run
+		    run = b1 & 0x3f;
+		}
+		index[(r * 3 + g * 5 + b * 7 + a * 11) % 64] = ((a << 24) | (r << 16) | (g << 8) | b) >>> 0;
+	    }
+	    pixels[o++] = r;
+	    pixels[o++] = g;
+	    pixels[o++] = b;
+	    pixels[o++] = a;
+	}
+    }
+}
+
+/* Copies a full tile between the image and a cache slot */
+function copyTile(pixels, w, tx, ty, tile, toCache)
+{
+    var rowBytes = TILE_SIZE * 4;
+    for (var y = 0; y < TILE_SIZE; y++) {
+	var o = ((ty + y) * w + tx) * 4;
+	var row = pixels.subarray(o, o + rowBytes);
+	if (toCache)
+	    tile.set(row, y * rowBytes);
+	else
+	    pixels.set(tile.subarray(y * rowBytes, (y + 1) * rowBytes), o);
+    }
+}
+
+function decodeTiles(u8, pos, w, h, pixels)
+{
+    for (var ty = 0; ty < h; ty += TILE_SIZE) {
+	var th = Math.min(TILE_SIZE, h - ty);
+	for (var tx = 0; tx < w; tx += TILE_SIZE) {
+	    var tw = Math.min(TILE_SIZE, w - tx);
+	    var type = u8[pos++];
+	    var slot, len, x, y, o;
+
+	    switch (type) {
+	    case 0: // Solid
+		var r = u8[pos++];
+		var g = u8[pos++];
+		var b = u8[pos++];
+		var a = u8[pos++];
+		for (y = 0; y < th; y++) {
+		    o = ((ty + y) * w + tx) * 4;
+		    for (x = 0; x < tw; x++) {
+			pixels[o++] = r;
+			pixels[o++] = g;
+			pixels[o++] = b;
+			pixels[o++] = a;
+		    }
+		}
+		break;
+
+	    case 1: // QOI
+		len = u8[pos] + (u8[pos+1] << 8) + (u8[pos+2] << 16) + (u8[pos+3] << 24);
+		pos += 4;
+		decodeQoiTile(u8, pos, pos + len, pixels, w, tx, ty, tw, th);
+		pos += len;
+		break;
+
+	    case 2: // Cached
+		slot = u8[pos] + (u8[pos+1] << 8);
+		pos += 2;
+		copyTile(pixels, w, tx, ty, tileCache[slot], false);
+		break;
+
+	    case 3: // QOI, stored in the cache
+		slot = u8[pos] + (u8[pos+1] << 8);
+		len = u8[pos+2] + (u8[pos+3] << 8) + (u8[pos+4] << 16) + (u8[pos+5] << 24);
+		pos += 6;
+		decodeQoiTile(u8, pos, pos + len, pixels, w, tx, ty, tw, th);
+		pos += len;
+		if (tileCache[slot] == undefined)
+		    tileCache[slot] = new Uint8Array(TILE_SIZE * TILE_SIZE * 4);
+		copyTile(pixels, w, tx, ty, tileCache[slot], true);
+		break;
+
+	    default:
+		alert("Unknown tile type " + type);
+		return;
+	    }
+	}
+    }
+}
 
 function handleMessage(message)
 {
@@ -2678,9 +2835,17 @@ function connect()
     var loc = window.location.toString().replace("http:", "ws:").replace("https:", "wss:");
     loc = loc.substr(0, loc.lastIndexOf('/')) + "/socket";
 
+    var use_png = false;
+    if (params) {
+	for (var i = 0; i < params.length; i++) {
+	    if (params[i] == "encoding=png")
+		use_png = true;
+	}
+    }
+
     var supports_binary = newWS (loc + "-test").binaryType == "blob";
     if (supports_binary) {
-	ws = newWS (loc + "-bin");
+	ws = newWS (loc + (use_png ? "-bin" : "-tiles"));
 	ws.binaryType = "arraybuffer";
     } else {
 	ws = newWS (loc);
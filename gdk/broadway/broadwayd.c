@@ -288,9 +288,16 @@ client_handle_request (BroadwayClient *client,
 					      request->update.height);
       if (surface != NULL)
 	{
+	  area = NULL;
+	  if (request->update.n_rects > 0)
+	    area = region_from_rects (request->update.rects,
+				      request->update.n_rects);
 	  broadway_server_window_update (server,
 					 request->update.id,
-					 surface);
+					 surface,
+					 area);
+	  if (area)
+	    cairo_region_destroy (area);
 	  cairo_surface_destroy (surface);
 	}
       break;
@@ -370,6 +377,8 @@ client_fill_cb (GObject *source_object,
 	      remaining -= size;
 	      buffer += size;
 	    }
+	  else
+	    break;
 	}
       
       /* This is guaranteed not to block */
@@ -605,10 +605,14 @@ _gdk_broadway_server_create_surface (int                 width,
 void
 _gdk_broadway_server_window_update (GdkBroadwayServer *server,
 				    gint id,
-				    cairo_surface_t *surface)
+				    cairo_surface_t *surface,
+				    cairo_region_t *damage)
 {
-  BroadwayRequestUpdate msg;
+  BroadwayRequestUpdate *msg;
   BroadwayShmSurfaceData *data;
+  cairo_rectangle_int_t rect;
+  int i, n_rects;
+  gsize msg_size;
 
   if (surface == NULL)
     return;
@@ -616,13 +620,29 @@ _gdk_broadway_server_window_update (GdkBroadwayServer *server,
   data = cairo_surface_get_user_data (surface, &gdk_broadway_shm_cairo_key);
   g_assert (data != NULL);
 
-  msg.id = id;
-  memcpy (msg.name, data->name, 36);
-  msg.width = cairo_image_surface_get_width (surface);
-  msg.height = cairo_image_surface_get_height (surface);
+  n_rects = damage ? cairo_region_num_rectangles (damage) : 0;
 
-  gdk_broadway_server_send_message (server, msg,
-				    BROADWAY_REQUEST_UPDATE);
+  msg_size = sizeof (BroadwayRequestUpdate) + MAX (n_rects - 1, 0) * sizeof (BroadwayRect);
+  msg = g_malloc (msg_size);
+
+  msg->id = id;
+  memcpy (msg->name, data->name, 36);
+  msg->width = cairo_image_surface_get_width (surface);
+  msg->height = cairo_image_surface_get_height (surface);
+  msg->n_rects = n_rects;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_region_get_rectangle (damage, i, &rect);
+      msg->rects[i].x = rect.x;
+      msg->rects[i].y = rect.y;
+      msg->rects[i].width = rect.width;
+      msg->rects[i].height = rect.height;
+    }
+
+  gdk_broadway_server_send_message_with_size (server, (BroadwayRequestBase *)msg, msg_size,
+					      BROADWAY_REQUEST_UPDATE);
+  g_free (msg);
 }
 
 gboolean
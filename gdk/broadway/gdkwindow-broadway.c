@@ -83,6 +83,11 @@ G_DEFINE_TYPE (GdkWindowImplBroadway,
 	       gdk_window_impl_broadway,
 	       GDK_TYPE_WINDOW_IMPL)
 
+/* Damage regions with more rectangles than this are sent as their
+ * extents, to keep update requests small.
+ */
+#define MAX_DAMAGE_RECTS 32
+
 static void
 update_dirty_windows_and_sync (void)
 {
@@ -101,9 +106,23 @@ update_dirty_windows_and_sync (void)
 	{
 	  impl->dirty = FALSE;
 	  updated_surface = TRUE;
+
+	  if (cairo_region_num_rectangles (impl->damage) > MAX_DAMAGE_RECTS)
+	    {
+	      cairo_rectangle_int_t extents;
+
+	      cairo_region_get_extents (impl->damage, &extents);
+	      cairo_region_destroy (impl->damage);
+	      impl->damage = cairo_region_create_rectangle (&extents);
+	    }
+
 	  _gdk_broadway_server_window_update (display->server,
 					      impl->id,
-					      impl->surface);
+					      impl->surface,
+					      impl->damage);
+
+	  cairo_region_destroy (impl->damage);
+	  impl->damage = cairo_region_create ();
 	}
     }
 
@@ -141,6 +160,7 @@ static void
 gdk_window_impl_broadway_init (GdkWindowImplBroadway *impl)
 {
   impl->toplevel_window_type = -1;
+  impl->damage = cairo_region_create ();
   impl->device_cursor = g_hash_table_new_full (NULL, NULL, NULL,
                                                (GDestroyNotify) g_object_unref);
 }
@@ -168,6 +188,7 @@ gdk_window_impl_broadway_finalize (GObject *object)
     g_object_unref (impl->cursor);
 
   g_hash_table_destroy (impl->device_cursor);
+  cairo_region_destroy (impl->damage);
 
   broadway_display->toplevels = g_list_remove (broadway_display->toplevels, impl);
 
@@ -480,6 +501,8 @@ gdk_window_broadway_move_resize (GdkWindow *window,
       if (width != window->width ||
 	  height != window->height)
 	{
+	  cairo_rectangle_int_t rect;
+
 	  size_changed = TRUE;
 
 	  /* Resize clears the content */
@@ -488,6 +511,12 @@ gdk_window_broadway_move_resize (GdkWindow *window,
 
 	  window->width = width;
 	  window->height = height;
+
+	  rect.x = 0;
+	  rect.y = 0;
+	  rect.width = width;
+	  rect.height = height;
+	  cairo_region_union_rectangle (impl->damage, &rect);
 	  _gdk_broadway_window_resize_surface (window);
 	}
     }
@@ -1447,9 +1476,11 @@ gdk_broadway_window_process_updates_recurse (GdkWindow *window,
 {
   GdkWindowImplBroadway *impl;
 
+  impl = GDK_WINDOW_IMPL_BROADWAY (window->impl);
+  cairo_region_union (impl->damage, region);
+
   _gdk_window_process_updates_recurse (window, region);
 
-  impl = GDK_WINDOW_IMPL_BROADWAY (window->impl);
   impl->dirty = TRUE;
 }
 
@@ -63,6 +63,7 @@ struct _GdkWindowImplBroadway
 
   gint8 toplevel_window_type;
   gboolean dirty;
+  cairo_region_t *damage;
   gboolean last_synced;
 
   GdkGeometry geometry_hints;
@@ -515,6 +515,10 @@ _gdk_frame_clock_debug_print_timings (GdkFrameClock   *clock,
     }
   if (timings->layout_start_time != 0)
     g_print (" layout_start=%-4.1f", (timings->layout_start_time - timings->frame_time) / 1000.);
+  if (timings->layout_passes > 1)
+    g_print (" layout_passes=%d", timings->layout_passes);
+  if (timings->layout_deferred_time != 0)
+    g_print (" layout_deferred=%-4.1f", timings->layout_deferred_time / 1000.);
   if (timings->paint_start_time != 0)
     g_print (" paint_start=%-4.1f", (timings->paint_start_time - timings->frame_time) / 1000.);
   if (timings->frame_end_time != 0)
@@ -54,6 +54,11 @@ struct _GdkFrameClockIdlePrivate
   GdkFrameClockPhase requested;
   GdkFrameClockPhase phase;
 
+#ifdef G_ENABLE_DEBUG
+  /* when layout was last left requested at the end of a frame */
+  gint64 layout_deferred_since;
+#endif /* G_ENABLE_DEBUG */
+
   guint in_paint_idle : 1;
 #ifdef G_OS_WIN32
   guint begin_period : 1;
@@ -390,7 +395,15 @@ gdk_frame_clock_paint_idle (void *data)
                 {
                   if (priv->phase != GDK_FRAME_CLOCK_PHASE_LAYOUT &&
                       (priv->requested & GDK_FRAME_CLOCK_PHASE_LAYOUT))
-                    timings->layout_start_time = g_get_monotonic_time ();
+                    {
+                      timings->layout_start_time = g_get_monotonic_time ();
+                      if (priv->layout_deferred_since != 0)
+                        {
+                          timings->layout_deferred_time =
+                            timings->layout_start_time - priv->layout_deferred_since;
+                          priv->layout_deferred_since = 0;
+                        }
+                    }
                 }
 #endif /* G_ENABLE_DEBUG */
 
@@ -409,6 +422,19 @@ gdk_frame_clock_paint_idle (void *data)
                 }
 	      if (iter == 5)
 		g_warning ("gdk-frame-clock: layout continuously requested, giving up after 4 tries");
+#ifdef G_ENABLE_DEBUG
+              if ((_gdk_debug_flags & GDK_DEBUG_FRAMES) != 0)
+                {
+                  /* The loop stops early when the clock gets frozen
+                   * as well, in which case layout continues in the
+                   * next frame.
+                   */
+                  timings->layout_passes += MIN (iter, 4);
+                  if ((priv->requested & GDK_FRAME_CLOCK_PHASE_LAYOUT) &&
+                      priv->layout_deferred_since == 0)
+                    priv->layout_deferred_since = g_get_monotonic_time ();
+                }
+#endif /* G_ENABLE_DEBUG */
             }
         case GDK_FRAME_CLOCK_PHASE_PAINT:
           if (priv->freeze_count == 0)
@@ -81,6 +81,8 @@ struct _GdkFrameTimings
   gint64 layout_start_time;
   gint64 paint_start_time;
   gint64 frame_end_time;
+  gint layout_passes;       /* times ::layout was emitted */
+  gint64 layout_deferred_time; /* how long layout waited after a frame gave up on it */
 #endif /* G_ENABLE_DEBUG */
 
   guint complete : 1;
@@ -24,194 +24,653 @@
 #include "gtkcairoblurprivate.h"
 
 #include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define GTK_CAIRO_BLUR_NEON 1
+#endif
 
 /*
  * Notes:
- *   based on exponential-blur algorithm by Jani Huhtanen
+ *   The gaussian is approximated by three successive box blurs, as
+ *   described for feGaussianBlur in the SVG specification:
+ *   http://www.w3.org/TR/SVG11/filters.html#feGaussianBlurElement
+ *
+ *   Each box blur is a running sum, so the cost per pixel does not
+ *   depend on the radius. The four channels of a pixel are summed in
+ *   one vector register where SSE2 or NEON are available. A8 surfaces
+ *   are blurred one byte at a time along the rows and four columns at
+ *   a time down the columns, since columns are blurred independently. Large
+ *   surfaces are split into bands that are blurred on a thread pool.
  */
+
+/* 3 * sqrt (2 * pi) / 4, the box size that approximates a gaussian
+ * with a standard deviation of 1 */
+#define GAUSSIAN_SCALE_FACTOR 1.8799712059732503
+
+/* Surfaces with fewer pixels than this are blurred on the calling thread */
+#define BLUR_THREAD_MIN_PIXELS (256 * 256)
+/* The minimum number of rows or columns handed to a single thread */
+#define BLUR_THREAD_MIN_BAND 64
+
+/* BlurSum: the running sum of the 4 channels of a span of pixels */
+
+#if defined(__SSE2__)
+
+typedef __m128i BlurSum;
+typedef __m128  BlurScale;
+
+static inline BlurSum
+blur_sum_zero (void)
+{
+  return _mm_setzero_si128 ();
+}
+
+static inline BlurSum
+blur_sum_load_pixel (const guchar *pixel)
+{
+  __m128i zero = _mm_setzero_si128 ();
+  guint32 word;
+  __m128i v;
+
+  memcpy (&word, pixel, 4);
+  v = _mm_cvtsi32_si128 (word);
+  v = _mm_unpacklo_epi8 (v, zero);
+
+  return _mm_unpacklo_epi16 (v, zero);
+}
+
+static inline BlurSum
+blur_sum_add (BlurSum a, BlurSum b)
+{
+  return _mm_add_epi32 (a, b);
+}
+
+static inline BlurSum
+blur_sum_sub (BlurSum a, BlurSum b)
+{
+  return _mm_sub_epi32 (a, b);
+}
+
+static inline BlurSum
+blur_sum_get (const gint32 *sums)
+{
+  return _mm_loadu_si128 ((const __m128i *) sums);
+}
+
 static inline void
-_blurinner (guchar* pixel,
-            gint   *zR,
-            gint   *zG,
-            gint   *zB,
-            gint   *zA,
-            gint    alpha,
-            gint    aprec,
-            gint    zprec)
-{
-  gint R;
-  gint G;
-  gint B;
-  guchar A;
-
-  R = *pixel;
-  G = *(pixel + 1);
-  B = *(pixel + 2);
-  A = *(pixel + 3);
-
-  *zR += (alpha * ((R << zprec) - *zR)) >> aprec;
-  *zG += (alpha * ((G << zprec) - *zG)) >> aprec;
-  *zB += (alpha * ((B << zprec) - *zB)) >> aprec;
-  *zA += (alpha * ((A << zprec) - *zA)) >> aprec;
-
-  *pixel       = *zR >> zprec;
-  *(pixel + 1) = *zG >> zprec;
-  *(pixel + 2) = *zB >> zprec;
-  *(pixel + 3) = *zA >> zprec;
-} 
+blur_sum_put (gint32  *sums,
+              BlurSum  sum)
+{
+  _mm_storeu_si128 ((__m128i *) sums, sum);
+}
+
+static inline BlurScale
+blur_scale_new (gint d)
+{
+  return _mm_set1_ps (1.0f / d);
+}
 
 static inline void
-_blurrow (guchar* pixels,
-          gint    width,
-          gint    height,
-          gint    rowstride,
-          gint    channels,
-          gint    line,
-          gint    alpha,
-          gint    aprec,
-          gint    zprec)
-{
-  gint    zR;
-  gint    zG;
-  gint    zB;
-  gint    zA;
-  gint    index;
-  guchar* scanline;
-
-  scanline = &pixels[line * rowstride];
-
-  zR = *scanline << zprec;
-  zG = *(scanline + 1) << zprec;
-  zB = *(scanline + 2) << zprec;
-  zA = *(scanline + 3) << zprec;
-
-  for (index = 0; index < width; index ++)
-    _blurinner (&scanline[index * channels],
-                &zR,
-                &zG,
-                &zB,
-                &zA,
-                alpha,
-                aprec,
-                zprec);
-
-  for (index = width - 2; index >= 0; index--)
-    _blurinner (&scanline[index * channels],
-                &zR,
-                &zG,
-                &zB,
-                &zA,
-                alpha,
-                aprec,
-                zprec);
+blur_sum_store_pixel (guchar    *pixel,
+                      BlurSum    sum,
+                      BlurScale  scale)
+{
+  guint32 word;
+  __m128i v;
+
+  v = _mm_cvtps_epi32 (_mm_mul_ps (_mm_cvtepi32_ps (sum), scale));
+  v = _mm_packs_epi32 (v, v);
+  v = _mm_packus_epi16 (v, v);
+  word = _mm_cvtsi128_si32 (v);
+  memcpy (pixel, &word, 4);
+}
+
+#elif defined(GTK_CAIRO_BLUR_NEON)
+
+typedef int32x4_t   BlurSum;
+typedef float32x4_t BlurScale;
+
+static inline BlurSum
+blur_sum_zero (void)
+{
+  return vdupq_n_s32 (0);
+}
+
+static inline BlurSum
+blur_sum_load_pixel (const guchar *pixel)
+{
+  guint32 word;
+  uint16x8_t v;
+
+  memcpy (&word, pixel, 4);
+  v = vmovl_u8 (vreinterpret_u8_u32 (vdup_n_u32 (word)));
+
+  return vreinterpretq_s32_u32 (vmovl_u16 (vget_low_u16 (v)));
+}
+
+static inline BlurSum
+blur_sum_add (BlurSum a, BlurSum b)
+{
+  return vaddq_s32 (a, b);
+}
+
+static inline BlurSum
+blur_sum_sub (BlurSum a, BlurSum b)
+{
+  return vsubq_s32 (a, b);
+}
+
+static inline BlurSum
+blur_sum_get (const gint32 *sums)
+{
+  return vld1q_s32 (sums);
 }
 
 static inline void
-_blurcol (guchar* pixels,
-          gint    width,
-          gint    height,
-          gint    rowstride,
-          gint    channels,
-          gint    x,
-          gint    alpha,
-          gint    aprec,
-          gint    zprec)
-{
-  gint zR;
-  gint zG;
-  gint zB;
-  gint zA;
-  gint index;
-  guchar* ptr;
-
-  ptr = pixels;
-  
-  ptr += x * channels;
-
-  zR = *((guchar*) ptr    ) << zprec;
-  zG = *((guchar*) ptr + 1) << zprec;
-  zB = *((guchar*) ptr + 2) << zprec;
-  zA = *((guchar*) ptr + 3) << zprec;
-
-  for (index = 0; index < height; index++)
-    _blurinner (&ptr[index * rowstride],
-                &zR,
-                &zG,
-                &zB,
-                &zA,
-                alpha,
-                aprec,
-                zprec);
-
-  for (index = height - 2; index >= 0; index--)
-    _blurinner (&ptr[index * rowstride],
-                &zR,
-                &zG,
-                &zB,
-                &zA,
-                alpha,
-                aprec,
-                zprec);
+blur_sum_put (gint32  *sums,
+              BlurSum  sum)
+{
+  vst1q_s32 (sums, sum);
 }
 
+static inline BlurScale
+blur_scale_new (gint d)
+{
+  return vdupq_n_f32 (1.0f / d);
+}
+
+static inline void
+blur_sum_store_pixel (guchar    *pixel,
+                      BlurSum    sum,
+                      BlurScale  scale)
+{
+  float32x4_t f;
+  uint16x4_t n;
+  guint32 word;
+
+  f = vmlaq_f32 (vdupq_n_f32 (0.5f), vcvtq_f32_s32 (sum), scale);
+  n = vmovn_u32 (vcvtq_u32_f32 (f));
+  word = vget_lane_u32 (vreinterpret_u32_u8 (vmovn_u16 (vcombine_u16 (n, n))), 0);
+  memcpy (pixel, &word, 4);
+}
+
+#else
+
+typedef struct { gint32 c[4]; } BlurSum;
+typedef gint BlurScale;
+
+static inline BlurSum
+blur_sum_zero (void)
+{
+  BlurSum sum = { { 0, 0, 0, 0 } };
+
+  return sum;
+}
+
+static inline BlurSum
+blur_sum_load_pixel (const guchar *pixel)
+{
+  BlurSum sum;
+
+  sum.c[0] = pixel[0];
+  sum.c[1] = pixel[1];
+  sum.c[2] = pixel[2];
+  sum.c[3] = pixel[3];
+
+  return sum;
+}
+
+static inline BlurSum
+blur_sum_add (BlurSum a, BlurSum b)
+{
+  a.c[0] += b.c[0];
+  a.c[1] += b.c[1];
+  a.c[2] += b.c[2];
+  a.c[3] += b.c[3];
+
+  return a;
+}
+
+static inline BlurSum
+blur_sum_sub (BlurSum a, BlurSum b)
+{
+  a.c[0] -= b.c[0];
+  a.c[1] -= b.c[1];
+  a.c[2] -= b.c[2];
+  a.c[3] -= b.c[3];
+
+  return a;
+}
+
+static inline BlurSum
+blur_sum_get (const gint32 *sums)
+{
+  BlurSum sum;
+
+  memcpy (sum.c, sums, sizeof (sum.c));
+
+  return sum;
+}
+
+static inline void
+blur_sum_put (gint32  *sums,
+              BlurSum  sum)
+{
+  memcpy (sums, sum.c, sizeof (sum.c));
+}
+
+static inline BlurScale
+blur_scale_new (gint d)
+{
+  return d;
+}
+
+static inline void
+blur_sum_store_pixel (guchar    *pixel,
+                      BlurSum    sum,
+                      BlurScale  d)
+{
+  pixel[0] = (sum.c[0] + d / 2) / d;
+  pixel[1] = (sum.c[1] + d / 2) / d;
+  pixel[2] = (sum.c[2] + d / 2) / d;
+  pixel[3] = (sum.c[3] + d / 2) / d;
+}
+
+#endif
+
 /*
- * _expblur:
+ * get_box_filter_size:
+ * @radius: the blur radius
+ *
+ * Returns the size of the box that approximates a gaussian when
+ * applied three times. The CSS blur radius is twice the standard
+ * deviation of the gaussian.
+ */
+static gint
+get_box_filter_size (double radius)
+{
+  return (gint) floor (radius / 2.0 * GAUSSIAN_SCALE_FACTOR + 0.5);
+}
+
+/*
+ * get_lobes:
+ * @d: the box filter size
+ * @lobes: (out): the extent to the left and right of each of the
+ *   three box blurs
+ *
+ * For odd sizes all three boxes are centered on the output pixel. For
+ * even sizes the first two are shifted by half a pixel to the left and
+ * to the right and the third one has a size of d + 1.
+ */
+static void
+get_lobes (gint d,
+           gint lobes[3][2])
+{
+  gint major = d / 2;
+  gint minor = d % 2 ? major : major - 1;
+
+  lobes[0][0] = major;
+  lobes[0][1] = minor;
+  lobes[1][0] = minor;
+  lobes[1][1] = major;
+  lobes[2][0] = major;
+  lobes[2][1] = major;
+}
+
+/* Box blurs @width pixels from @src into @dst. Pixels outside the
+ * span count as transparent. */
+static void
+box_blur_span (const guchar *src,
+               guchar       *dst,
+               gint          width,
+               gint          left,
+               gint          right)
+{
+  BlurScale scale = blur_scale_new (left + right + 1);
+  BlurSum sum = blur_sum_zero ();
+  gint i;
+
+  for (i = 0; i <= right && i < width; i++)
+    sum = blur_sum_add (sum, blur_sum_load_pixel (src + 4 * i));
+
+  for (i = 0; i < width; i++)
+    {
+      blur_sum_store_pixel (dst + 4 * i, sum, scale);
+
+      if (i + right + 1 < width)
+        sum = blur_sum_add (sum, blur_sum_load_pixel (src + 4 * (i + right + 1)));
+      if (i - left >= 0)
+        sum = blur_sum_sub (sum, blur_sum_load_pixel (src + 4 * (i - left)));
+    }
+}
+
+/* Like box_blur_span(), for single channel pixels */
+static void
+box_blur_span_a8 (const guchar *src,
+                  guchar       *dst,
+                  gint          width,
+                  gint          left,
+                  gint          right)
+{
+  gint d = left + right + 1;
+  gint sum = 0;
+  gint i;
+
+  for (i = 0; i <= right && i < width; i++)
+    sum += src[i];
+
+  for (i = 0; i < width; i++)
+    {
+      dst[i] = (sum + d / 2) / d;
+
+      if (i + right + 1 < width)
+        sum += src[i + right + 1];
+      if (i - left >= 0)
+        sum -= src[i - left];
+    }
+}
+
+/* Box blurs a band of @width columns from @src into @dst. Instead of
+ * walking down each column, the sums of all columns are carried along
+ * one row at a time, which keeps memory access sequential. */
+static void
+box_blur_columns (const guchar *src,
+                  gint          src_stride,
+                  guchar       *dst,
+                  gint          dst_stride,
+                  gint          width,
+                  gint          height,
+                  gint          top,
+                  gint          bottom,
+                  gint32       *sums)
+{
+  BlurScale scale = blur_scale_new (top + bottom + 1);
+  const guchar *add, *sub;
+  guchar *out;
+  BlurSum sum;
+  gint x, y;
+
+  memset (sums, 0, width * 4 * sizeof (gint32));
+
+  for (y = 0; y <= bottom && y < height; y++)
+    {
+      add = src + y * src_stride;
+
+      for (x = 0; x < width; x++)
+        blur_sum_put (sums + 4 * x,
+                      blur_sum_add (blur_sum_get (sums + 4 * x),
+                                    blur_sum_load_pixel (add + 4 * x)));
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      out = dst + y * dst_stride;
+      add = y + bottom + 1 < height ? src + (y + bottom + 1) * src_stride : NULL;
+      sub = y - top >= 0 ? src + (y - top) * src_stride : NULL;
+
+      for (x = 0; x < width; x++)
+        {
+          sum = blur_sum_get (sums + 4 * x);
+
+          blur_sum_store_pixel (out + 4 * x, sum, scale);
+
+          if (add)
+            sum = blur_sum_add (sum, blur_sum_load_pixel (add + 4 * x));
+          if (sub)
+            sum = blur_sum_sub (sum, blur_sum_load_pixel (sub + 4 * x));
+
+          blur_sum_put (sums + 4 * x, sum);
+        }
+    }
+}
+
+static void
+blur_rows (guchar *pixels,
+           gint    width,
+           gint    rowstride,
+           gint    channels,
+           gint    first,
+           gint    last,
+           gint    d)
+{
+  void (* blur_span) (const guchar *, guchar *, gint, gint, gint);
+  gint lobes[3][2];
+  guchar *tmp, *row;
+  gint y;
+
+  get_lobes (d, lobes);
+  blur_span = channels == 4 ? box_blur_span : box_blur_span_a8;
+  tmp = g_malloc (width * channels);
+
+  for (y = first; y < last; y++)
+    {
+      row = pixels + y * rowstride;
+
+      blur_span (row, tmp, width, lobes[0][0], lobes[0][1]);
+      blur_span (tmp, row, width, lobes[1][0], lobes[1][1]);
+      blur_span (row, tmp, width, lobes[2][0], lobes[2][1]);
+      memcpy (row, tmp, width * channels);
+    }
+
+  g_free (tmp);
+}
+
+static void
+blur_columns (guchar *pixels,
+              gint    height,
+              gint    rowstride,
+              gint    first,
+              gint    last,
+              gint    d)
+{
+  gint lobes[3][2];
+  gint width, stride, y;
+  guchar *band, *tmp;
+  gint32 *sums;
+
+  get_lobes (d, lobes);
+  width = last - first;
+  stride = width * 4;
+  band = pixels + first * 4;
+  tmp = g_malloc (height * stride);
+  sums = g_new (gint32, width * 4);
+
+  box_blur_columns (band, rowstride, tmp, stride, width, height, lobes[0][0], lobes[0][1], sums);
+  box_blur_columns (tmp, stride, band, rowstride, width, height, lobes[1][0], lobes[1][1], sums);
+  box_blur_columns (band, rowstride, tmp, stride, width, height, lobes[2][0], lobes[2][1], sums);
+
+  for (y = 0; y < height; y++)
+    memcpy (band + y * rowstride, tmp + y * stride, stride);
+
+  g_free (sums);
+  g_free (tmp);
+}
+
+typedef struct _BlurJob BlurJob;
+typedef struct _BlurBand BlurBand;
+
+struct _BlurJob {
+  guchar *pixels;
+  gint    width;
+  gint    height;
+  gint    rowstride;
+  gint    channels;
+  gint    column_units;
+  gint    d;
+  guint   columns : 1;
+
+  GMutex  mutex;
+  GCond   cond;
+  guint   pending;
+};
+
+struct _BlurBand {
+  BlurJob *job;
+  gint     first;
+  gint     last;
+};
+
+static void
+blur_band (BlurBand *band)
+{
+  BlurJob *job = band->job;
+
+  if (job->columns)
+    blur_columns (job->pixels, job->height, job->rowstride, band->first, band->last, job->d);
+  else
+    blur_rows (job->pixels, job->width, job->rowstride, job->channels, band->first, band->last, job->d);
+}
+
+static void
+blur_band_thread_func (gpointer data,
+                       gpointer user_data)
+{
+  BlurBand *band = data;
+  BlurJob *job = band->job;
+
+  blur_band (band);
+
+  g_mutex_lock (&job->mutex);
+  job->pending--;
+  if (job->pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+static GThreadPool *
+get_blur_pool (void)
+{
+  static GThreadPool *pool = NULL;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (blur_band_thread_func,
+                                    NULL,
+                                    g_get_num_processors (),
+                                    FALSE,
+                                    NULL);
+
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  return pool;
+}
+
+/* Splits the rows or columns of @job into @n_bands bands. All but the
+ * last band are pushed to the thread pool, the last one is blurred on
+ * the calling thread while the others run. */
+static void
+blur_job_run (BlurJob *job,
+              guint    n_bands)
+{
+  BlurBand *bands;
+  gint size;
+  guint i;
+
+  size = job->columns ? job->column_units : job->height;
+  bands = g_newa (BlurBand, n_bands);
+
+  for (i = 0; i < n_bands; i++)
+    {
+      bands[i].job = job;
+      bands[i].first = size * i / n_bands;
+      bands[i].last = size * (i + 1) / n_bands;
+    }
+
+  job->pending = n_bands - 1;
+  for (i = 0; i + 1 < n_bands; i++)
+    g_thread_pool_push (get_blur_pool (), &bands[i], NULL);
+
+  blur_band (&bands[n_bands - 1]);
+
+  g_mutex_lock (&job->mutex);
+  while (job->pending > 0)
+    g_cond_wait (&job->cond, &job->mutex);
+  g_mutex_unlock (&job->mutex);
+}
+
+/*
+ * _boxblur:
  * @pixels: image data
  * @width: image width
  * @height: image height
  * @rowstride: image rowstride
- * @channels: image channels
- * @radius: kernel radius
- * @aprec: precision of alpha parameter in fixed-point format 0.aprec
- * @zprec: precision of state parameters zR,zG,zB and zA in fp format 8.zprec
- *
- * Performs an in-place blur of image data 'pixels'
- * with kernel of approximate radius 'radius'.
- *
- * Blurs with two sided exponential impulse response.
+ * @channels: image channels, 4 or 1
+ * @d: box filter size
+ * @n_threads: maximum number of threads to use
  *
+ * Performs an in-place triple box blur of image data 'pixels',
+ * first along the rows and then along the columns.
  */
 static void
-_expblur (guchar* pixels,
+_boxblur (guchar *pixels,
           gint    width,
           gint    height,
           gint    rowstride,
           gint    channels,
-          double  radius,
-          gint    aprec,
-          gint    zprec)
-{
-  gint alpha;
-  int row, col;
-
-  /* Calculate the alpha such that 90% of 
-   * the kernel is within the radius.
-   * (Kernel extends to infinity) */
-  alpha = (gint) ((1 << aprec) * (1.0f - expf (-2.3f / (radius + 1.f))));
-
-  for (row = 0; row < height; row++)
-    _blurrow (pixels,
-              width,
-              height,
-              rowstride,
-              channels,
-              row,
-              alpha,
-              aprec,
-              zprec);
-
-  for(col = 0; col < width; col++)
-    _blurcol (pixels,
-              width,
-              height,
-              rowstride,
-              channels,
-              col,
-              alpha,
-              aprec,
-              zprec);
+          gint    d,
+          guint   n_threads)
+{
+  gint column_units;
+  BlurJob job;
+
+  if (d < 2)
+    return;
+
+  /* The column pass works on groups of 4 bytes. Rowstrides of cairo
+   * image surfaces are a multiple of 4, so for A8 this may blur some
+   * padding at the end of the rows, which is harmless. */
+  column_units = channels == 4 ? width : (width + 3) / 4;
+
+  if (n_threads <= 1)
+    {
+      blur_rows (pixels, width, rowstride, channels, 0, height, d);
+      blur_columns (pixels, height, rowstride, 0, column_units, d);
+      return;
+    }
+
+  job.pixels = pixels;
+  job.width = width;
+  job.height = height;
+  job.rowstride = rowstride;
+  job.channels = channels;
+  job.column_units = column_units;
+  job.d = d;
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  job.columns = FALSE;
+  blur_job_run (&job, CLAMP (height / BLUR_THREAD_MIN_BAND, 1, n_threads));
+
+  job.columns = TRUE;
+  blur_job_run (&job, CLAMP (column_units / BLUR_THREAD_MIN_BAND, 1, n_threads));
+
+  g_cond_clear (&job.cond);
+  g_mutex_clear (&job.mutex);
 }
 
+/*
+ * _gtk_cairo_blur_compute_pixels:
+ * @radius: the blur radius.
+ *
+ * Computes the number of pixels by which _gtk_cairo_blur_surface()
+ * spreads the content of a surface at the given radius. Content that
+ * is further away from an edge of the surface than this is not
+ * affected by the edge.
+ *
+ * Returns: the extent of the blur in pixels
+ */
+gint
+_gtk_cairo_blur_compute_pixels (double radius)
+{
+  return 3 * (get_box_filter_size (radius) / 2);
+}
 
 /*
  * _gtk_cairo_blur_surface:
@@ -225,13 +684,16 @@ _gtk_cairo_blur_surface (cairo_surface_t* surface,
                          double           radius)
 {
   cairo_format_t format;
+  gint width, height;
+  guint n_threads;
 
   g_return_if_fail (surface != NULL);
   g_return_if_fail (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE);
 
   format = cairo_image_surface_get_format (surface);
   g_return_if_fail (format == CAIRO_FORMAT_RGB24 ||
-                    format == CAIRO_FORMAT_ARGB32);
+                    format == CAIRO_FORMAT_ARGB32 ||
+                    format == CAIRO_FORMAT_A8);
 
   if (radius == 0)
     return;
@@ -239,14 +701,21 @@ _gtk_cairo_blur_surface (cairo_surface_t* surface,
   /* Before we mess with the surface execute any pending drawing. */
   cairo_surface_flush (surface);
 
-  _expblur (cairo_image_surface_get_data (surface),
-            cairo_image_surface_get_width (surface),
-            cairo_image_surface_get_height (surface),
+  width = cairo_image_surface_get_width (surface);
+  height = cairo_image_surface_get_height (surface);
+
+  if (width * height >= BLUR_THREAD_MIN_PIXELS)
+    n_threads = g_get_num_processors ();
+  else
+    n_threads = 1;
+
+  _boxblur (cairo_image_surface_get_data (surface),
+            width,
+            height,
             cairo_image_surface_get_stride (surface),
-            4,
-            radius,
-            16,
-            7);
+            format == CAIRO_FORMAT_A8 ? 1 : 4,
+            get_box_filter_size (radius),
+            n_threads);
 
   /* Inform cairo we altered the surfaces contents. */
   cairo_surface_mark_dirty (surface);
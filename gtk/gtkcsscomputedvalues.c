@@ -110,6 +110,60 @@ maybe_unref_section (gpointer section)
     gtk_css_section_unref (section);
 }
 
+/**
+ * _gtk_css_computed_values_copy:
+ * @values: the values to copy
+ *
+ * Creates a copy of the intrinsic values of @values. Animations are
+ * not copied.
+ *
+ * Returns: a new #GtkCssComputedValues
+ **/
+GtkCssComputedValues *
+_gtk_css_computed_values_copy (GtkCssComputedValues *values)
+{
+  GtkCssComputedValues *copy;
+  guint i;
+
+  gtk_internal_return_val_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values), NULL);
+
+  copy = _gtk_css_computed_values_new ();
+
+  if (values->values)
+    {
+      copy->values = g_ptr_array_new_full (values->values->len,
+                                           (GDestroyNotify)_gtk_css_value_unref);
+      for (i = 0; i < values->values->len; i++)
+        {
+          GtkCssValue *value = g_ptr_array_index (values->values, i);
+
+          g_ptr_array_add (copy->values, value ? _gtk_css_value_ref (value) : NULL);
+        }
+    }
+
+  if (values->sections)
+    {
+      copy->sections = g_ptr_array_new_full (values->sections->len, maybe_unref_section);
+      for (i = 0; i < values->sections->len; i++)
+        {
+          GtkCssSection *section = g_ptr_array_index (values->sections, i);
+
+          g_ptr_array_add (copy->sections, section ? gtk_css_section_ref (section) : NULL);
+        }
+    }
+
+  _gtk_bitmask_free (copy->depends_on_parent);
+  copy->depends_on_parent = _gtk_bitmask_copy (values->depends_on_parent);
+  _gtk_bitmask_free (copy->equals_parent);
+  copy->equals_parent = _gtk_bitmask_copy (values->equals_parent);
+  _gtk_bitmask_free (copy->depends_on_color);
+  copy->depends_on_color = _gtk_bitmask_copy (values->depends_on_color);
+  _gtk_bitmask_free (copy->depends_on_font_size);
+  copy->depends_on_font_size = _gtk_bitmask_copy (values->depends_on_font_size);
+
+  return copy;
+}
+
 void
 _gtk_css_computed_values_compute_value (GtkCssComputedValues    *values,
                                         GtkStyleProviderPrivate *provider,
@@ -575,6 +629,50 @@ _gtk_css_computed_values_advance (GtkCssComputedValues *values,
   return changed;
 }
 
+/**
+ * _gtk_css_computed_values_is_animatable:
+ * @values: the values to check
+ *
+ * Checks if _gtk_css_computed_values_create_animations() could
+ * possibly create animations or transitions for @values. If this
+ * function returns %FALSE, @values will never be animated.
+ *
+ * Returns: %TRUE if @values might get animated
+ **/
+gboolean
+_gtk_css_computed_values_is_animatable (GtkCssComputedValues *values)
+{
+  GtkCssValue *animations, *durations, *delays;
+  guint i;
+
+  gtk_internal_return_val_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values), TRUE);
+
+  animations = _gtk_css_computed_values_get_intrinsic_value (values, GTK_CSS_PROPERTY_ANIMATION_NAME);
+  for (i = 0; i < _gtk_css_array_value_get_n_values (animations); i++)
+    {
+      const char *name = _gtk_css_ident_value_get (_gtk_css_array_value_get_nth (animations, i));
+
+      if (g_ascii_strcasecmp (name, "none") != 0)
+        return TRUE;
+    }
+
+  durations = _gtk_css_computed_values_get_intrinsic_value (values, GTK_CSS_PROPERTY_TRANSITION_DURATION);
+  for (i = 0; i < _gtk_css_array_value_get_n_values (durations); i++)
+    {
+      if (_gtk_css_number_value_get (_gtk_css_array_value_get_nth (durations, i), 100) != 0.0)
+        return TRUE;
+    }
+
+  delays = _gtk_css_computed_values_get_intrinsic_value (values, GTK_CSS_PROPERTY_TRANSITION_DELAY);
+  for (i = 0; i < _gtk_css_array_value_get_n_values (delays); i++)
+    {
+      if (_gtk_css_number_value_get (_gtk_css_array_value_get_nth (delays, i), 100) != 0.0)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 gboolean
 _gtk_css_computed_values_is_static (GtkCssComputedValues *values)
 {
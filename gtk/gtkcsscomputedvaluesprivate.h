@@ -63,6 +63,7 @@ struct _GtkCssComputedValuesClass
 GType                   _gtk_css_computed_values_get_type             (void) G_GNUC_CONST;
 
 GtkCssComputedValues *  _gtk_css_computed_values_new                  (void);
+GtkCssComputedValues *  _gtk_css_computed_values_copy                 (GtkCssComputedValues     *values);
 
 void                    _gtk_css_computed_values_compute_value        (GtkCssComputedValues     *values,
                                                                        GtkStyleProviderPrivate  *provider,
@@ -99,6 +100,7 @@ GtkBitmask *            _gtk_css_computed_values_advance              (GtkCssCom
                                                                        gint64                    timestamp);
 void                    _gtk_css_computed_values_cancel_animations    (GtkCssComputedValues     *values);
 gboolean                _gtk_css_computed_values_is_static            (GtkCssComputedValues     *values);
+gboolean                _gtk_css_computed_values_is_animatable        (GtkCssComputedValues     *values);
 
 G_END_DECLS
 
@@ -19,6 +19,8 @@
 
 #include "gtkcssmatcherprivate.h"
 
+#include <string.h>
+
 #include "gtkwidgetpath.h"
 
 /* GTK_CSS_MATCHER_WIDGET_PATH */
@@ -35,6 +37,7 @@ gtk_css_matcher_widget_path_get_parent (GtkCssMatcher       *matcher,
   matcher->path.state_flags = 0;
   matcher->path.index = child->path.index - 1;
   matcher->path.sibling_index = gtk_widget_path_iter_get_sibling_index (matcher->path.path, matcher->path.index);
+  matcher->path.ancestors = child->path.ancestors;
 
   return TRUE;
 }
@@ -51,6 +54,7 @@ gtk_css_matcher_widget_path_get_previous (GtkCssMatcher       *matcher,
   matcher->path.state_flags = 0;
   matcher->path.index = next->path.index;
   matcher->path.sibling_index = next->path.sibling_index - 1;
+  matcher->path.ancestors = next->path.ancestors;
 
   return TRUE;
 }
@@ -173,6 +177,20 @@ gtk_css_matcher_widget_path_has_position (const GtkCssMatcher *matcher,
   return x / a > 0;
 }
 
+static gboolean
+gtk_css_matcher_widget_path_ancestors_may_have (const GtkCssMatcher *matcher,
+                                                guint                hash)
+{
+  const GtkCssAncestorFilter *filter = matcher->path.ancestors;
+  guint bit1, bit2;
+
+  bit1 = hash % GTK_CSS_ANCESTOR_FILTER_BITS;
+  bit2 = (hash >> 8) % GTK_CSS_ANCESTOR_FILTER_BITS;
+
+  return (filter->bits[bit1 / 32] & (1u << (bit1 % 32))) &&
+         (filter->bits[bit2 / 32] & (1u << (bit2 % 32)));
+}
+
 static const GtkCssMatcherClass GTK_CSS_MATCHER_WIDGET_PATH = {
   gtk_css_matcher_widget_path_get_parent,
   gtk_css_matcher_widget_path_get_previous,
@@ -183,9 +201,64 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_WIDGET_PATH = {
   gtk_css_matcher_widget_path_has_regions,
   gtk_css_matcher_widget_path_has_region,
   gtk_css_matcher_widget_path_has_position,
+  gtk_css_matcher_widget_path_ancestors_may_have,
   FALSE
 };
 
+static void
+gtk_css_ancestor_filter_add (GtkCssAncestorFilter *filter,
+                             GtkCssAncestorKind    kind,
+                             guint                 value)
+{
+  guint hash, bit1, bit2;
+
+  hash = _gtk_css_ancestor_filter_hash (kind, value);
+  bit1 = hash % GTK_CSS_ANCESTOR_FILTER_BITS;
+  bit2 = (hash >> 8) % GTK_CSS_ANCESTOR_FILTER_BITS;
+
+  filter->bits[bit1 / 32] |= 1u << (bit1 % 32);
+  filter->bits[bit2 / 32] |= 1u << (bit2 % 32);
+}
+
+static void
+gtk_css_ancestor_filter_init (GtkCssAncestorFilter *filter,
+                              const GtkWidgetPath  *path)
+{
+  GSList *list, *l;
+  const char *name;
+  GType type;
+  gint i, n_ancestors;
+
+  memset (filter, 0, sizeof (GtkCssAncestorFilter));
+
+  /* The last element is the widget itself, not a parent */
+  n_ancestors = gtk_widget_path_length (path) - 1;
+
+  for (i = 0; i < n_ancestors; i++)
+    {
+      /* Names match all parent types, see gtk_css_matcher_widget_path_has_type().
+       * Selectors for interfaces don't consult the filter. */
+      for (type = gtk_widget_path_iter_get_object_type (path, i);
+           type != G_TYPE_INVALID;
+           type = g_type_parent (type))
+        gtk_css_ancestor_filter_add (filter, GTK_CSS_ANCESTOR_NAME, (guint) type);
+
+      list = gtk_widget_path_iter_list_classes (path, i);
+      for (l = list; l; l = l->next)
+        gtk_css_ancestor_filter_add (filter, GTK_CSS_ANCESTOR_CLASS, g_quark_try_string (l->data));
+      g_slist_free (list);
+
+      list = gtk_widget_path_iter_list_regions (path, i);
+      for (l = list; l; l = l->next)
+        gtk_css_ancestor_filter_add (filter, GTK_CSS_ANCESTOR_REGION, g_str_hash (l->data));
+      g_slist_free (list);
+
+      name = gtk_widget_path_iter_get_name (path, i);
+      if (name)
+        gtk_css_ancestor_filter_add (filter, GTK_CSS_ANCESTOR_ID, g_str_hash (name));
+    }
+}
+
 gboolean
 _gtk_css_matcher_init (GtkCssMatcher       *matcher,
                        const GtkWidgetPath *path,
@@ -200,6 +273,9 @@ _gtk_css_matcher_init (GtkCssMatcher       *matcher,
   matcher->path.index = gtk_widget_path_length (path) - 1;
   matcher->path.sibling_index = gtk_widget_path_iter_get_sibling_index (path, matcher->path.index);
 
+  gtk_css_ancestor_filter_init (&matcher->path.ancestors_storage, path);
+  matcher->path.ancestors = &matcher->path.ancestors_storage;
+
   return TRUE;
 }
 
@@ -277,6 +353,13 @@ gtk_css_matcher_any_has_position (const GtkCssMatcher *matcher,
   return TRUE;
 }
 
+static gboolean
+gtk_css_matcher_any_ancestors_may_have (const GtkCssMatcher *matcher,
+                                        guint                hash)
+{
+  return TRUE;
+}
+
 static const GtkCssMatcherClass GTK_CSS_MATCHER_ANY = {
   gtk_css_matcher_any_get_parent,
   gtk_css_matcher_any_get_previous,
@@ -287,6 +370,7 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_ANY = {
   gtk_css_matcher_any_has_regions,
   gtk_css_matcher_any_has_region,
   gtk_css_matcher_any_has_position,
+  gtk_css_matcher_any_ancestors_may_have,
   TRUE
 };
 
@@ -396,6 +480,14 @@ gtk_css_matcher_superset_has_position (const GtkCssMatcher *matcher,
     return TRUE;
 }
 
+static gboolean
+gtk_css_matcher_superset_ancestors_may_have (const GtkCssMatcher *matcher,
+                                             guint                hash)
+{
+  /* parents are any matchers, see gtk_css_matcher_superset_get_parent() */
+  return TRUE;
+}
+
 static const GtkCssMatcherClass GTK_CSS_MATCHER_SUPERSET = {
   gtk_css_matcher_superset_get_parent,
   gtk_css_matcher_superset_get_previous,
@@ -406,6 +498,7 @@ static const GtkCssMatcherClass GTK_CSS_MATCHER_SUPERSET = {
   gtk_css_matcher_superset_has_regions,
   gtk_css_matcher_superset_has_region,
   gtk_css_matcher_superset_has_position,
+  gtk_css_matcher_superset_ancestors_may_have,
   FALSE
 };
 
@@ -28,6 +28,23 @@ typedef union _GtkCssMatcher GtkCssMatcher;
 typedef struct _GtkCssMatcherSuperset GtkCssMatcherSuperset;
 typedef struct _GtkCssMatcherWidgetPath GtkCssMatcherWidgetPath;
 typedef struct _GtkCssMatcherClass GtkCssMatcherClass;
+typedef struct _GtkCssAncestorFilter GtkCssAncestorFilter;
+
+typedef enum {
+  GTK_CSS_ANCESTOR_NAME,
+  GTK_CSS_ANCESTOR_CLASS,
+  GTK_CSS_ANCESTOR_ID,
+  GTK_CSS_ANCESTOR_REGION
+} GtkCssAncestorKind;
+
+/* A bloom filter of the types, classes, ids and regions of all parents
+ * of a widget path. It allows rejecting descendant selectors without
+ * walking the parents. */
+#define GTK_CSS_ANCESTOR_FILTER_BITS 256
+
+struct _GtkCssAncestorFilter {
+  guint32 bits[GTK_CSS_ANCESTOR_FILTER_BITS / 32];
+};
 
 struct _GtkCssMatcherClass {
   gboolean        (* get_parent)                  (GtkCssMatcher          *matcher,
@@ -50,6 +67,8 @@ struct _GtkCssMatcherClass {
                                                    gboolean               forward,
                                                    int                    a,
                                                    int                    b);
+  gboolean        (* ancestors_may_have)          (const GtkCssMatcher   *matcher,
+                                                   guint                  hash);
   gboolean is_any;
 };
 
@@ -59,6 +78,8 @@ struct _GtkCssMatcherWidgetPath {
   GtkStateFlags             state_flags;
   guint                     index;
   guint                     sibling_index;
+  const GtkCssAncestorFilter *ancestors;      /* shared by all matchers created from this one */
+  GtkCssAncestorFilter      ancestors_storage; /* only used by the matcher from _gtk_css_matcher_init() */
 };
 
 struct _GtkCssMatcherSuperset {
@@ -147,6 +168,26 @@ _gtk_css_matcher_has_position (const GtkCssMatcher *matcher,
   return matcher->klass->has_position (matcher, forward, a, b);
 }
 
+static inline guint
+_gtk_css_ancestor_filter_hash (GtkCssAncestorKind kind,
+                               guint              value)
+{
+  guint hash;
+
+  hash = value * 2654435761u + kind * 40503u;
+
+  return hash ^ (hash >> 15);
+}
+
+/* Returns FALSE if none of the parents of @matcher contains the
+ * name, class, id or region with the given hash. */
+static inline gboolean
+_gtk_css_matcher_ancestors_may_have (const GtkCssMatcher *matcher,
+                                     guint                hash)
+{
+  return matcher->klass->ancestors_may_have (matcher, hash);
+}
+
 static inline gboolean
 _gtk_css_matcher_matches_any (const GtkCssMatcher *matcher)
 {
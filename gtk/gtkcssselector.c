@@ -80,6 +80,13 @@ struct _GtkCssSelectorTree
   gint32 matches_offset; /* pointers that we return as matches if selector matches */
 };
 
+/* Statistics for the ancestor filter, printed with GTK_DEBUG=css-stats */
+static guint ancestor_checks_rejected = 0;
+static guint ancestor_checks_walked = 0;
+
+static gboolean gtk_css_selector_ancestors_may_match (const GtkCssSelector *selector,
+                                                      const GtkCssMatcher  *matcher);
+
 static gboolean
 gtk_css_selector_equal (const GtkCssSelector *a,
 			const GtkCssSelector *b)
@@ -238,6 +245,9 @@ gtk_css_selector_descendant_match (const GtkCssSelector *selector,
 {
   GtkCssMatcher ancestor;
 
+  if (!gtk_css_selector_ancestors_may_match (gtk_css_selector_previous (selector), matcher))
+    return FALSE;
+
   while (_gtk_css_matcher_get_parent (&ancestor, matcher))
     {
       matcher = &ancestor;
@@ -254,18 +264,30 @@ gtk_css_selector_descendant_tree_match (const GtkCssSelectorTree *tree,
 					const GtkCssMatcher  *matcher,
 					GHashTable *res)
 {
+  const GtkCssSelectorTree *prev;
+  const GtkCssMatcher *current;
   GtkCssMatcher ancestor;
 
-  while (_gtk_css_matcher_get_parent (&ancestor, matcher))
+  for (prev = gtk_css_selector_tree_get_previous (tree);
+       prev != NULL;
+       prev = gtk_css_selector_tree_get_sibling (prev))
     {
-      matcher = &ancestor;
+      /* Don't walk the parents if none of them can match */
+      if (!gtk_css_selector_ancestors_may_match (&prev->selector, matcher))
+        continue;
 
-      gtk_css_selector_tree_match_previous (tree, matcher, res);
+      current = matcher;
+      while (_gtk_css_matcher_get_parent (&ancestor, current))
+        {
+          current = &ancestor;
 
-      /* any matchers are dangerous here, as we may loop forever, but
-	 we can terminate now as all possible matches have already been added */
-      if (_gtk_css_matcher_matches_any (matcher))
-	break;
+          gtk_css_selector_tree_match (prev, current, res);
+
+          /* any matchers are dangerous here, as we may loop forever, but
+             we can terminate now as all possible matches have already been added */
+          if (_gtk_css_matcher_matches_any (current))
+            break;
+        }
     }
 }
 
@@ -335,6 +357,9 @@ gtk_css_selector_child_match (const GtkCssSelector *selector,
 {
   GtkCssMatcher parent;
 
+  if (!gtk_css_selector_ancestors_may_match (gtk_css_selector_previous (selector), matcher))
+    return FALSE;
+
   if (!_gtk_css_matcher_get_parent (&parent, matcher))
     return FALSE;
 
@@ -346,12 +371,19 @@ gtk_css_selector_child_tree_match (const GtkCssSelectorTree *tree,
 				   const GtkCssMatcher  *matcher,
 				   GHashTable *res)
 {
+  const GtkCssSelectorTree *prev;
   GtkCssMatcher parent;
 
   if (!_gtk_css_matcher_get_parent (&parent, matcher))
     return;
 
-  gtk_css_selector_tree_match_previous (tree, &parent, res);
+  for (prev = gtk_css_selector_tree_get_previous (tree);
+       prev != NULL;
+       prev = gtk_css_selector_tree_get_sibling (prev))
+    {
+      if (gtk_css_selector_ancestors_may_match (&prev->selector, matcher))
+        gtk_css_selector_tree_match (prev, &parent, res);
+    }
 }
 
 
@@ -1094,6 +1126,61 @@ static const GtkCssSelectorClass GTK_CSS_SELECTOR_ID = {
   TRUE, FALSE, FALSE, TRUE, FALSE
 };
 
+/* ANCESTOR FILTER */
+
+/* Uses the ancestor filter of @matcher to check if @selector can
+ * possibly match any parent of @matcher. Only names, classes, ids
+ * and regions can be checked, for all other selectors this function
+ * returns %TRUE. */
+static gboolean
+gtk_css_selector_ancestors_may_match (const GtkCssSelector *selector,
+                                      const GtkCssMatcher  *matcher)
+{
+  GtkCssAncestorKind kind;
+  guint value;
+
+  if (selector == NULL)
+    return TRUE;
+
+  if (selector->class == &GTK_CSS_SELECTOR_CLASS)
+    {
+      kind = GTK_CSS_ANCESTOR_CLASS;
+      value = GPOINTER_TO_UINT (selector->data);
+    }
+  else if (selector->class == &GTK_CSS_SELECTOR_ID)
+    {
+      kind = GTK_CSS_ANCESTOR_ID;
+      value = g_str_hash (selector->data);
+    }
+  else if (selector->class == &GTK_CSS_SELECTOR_REGION)
+    {
+      kind = GTK_CSS_ANCESTOR_REGION;
+      value = g_str_hash (selector->data);
+    }
+  else if (selector->class == &GTK_CSS_SELECTOR_NAME)
+    {
+      GType type = ((TypeReference *) selector->data)->type;
+
+      /* g_type_is_a() matches interfaces, but they are not in the filter */
+      if (G_TYPE_IS_INTERFACE (type))
+        return TRUE;
+
+      kind = GTK_CSS_ANCESTOR_NAME;
+      value = (guint) type;
+    }
+  else
+    return TRUE;
+
+  if (_gtk_css_matcher_ancestors_may_have (matcher, _gtk_css_ancestor_filter_hash (kind, value)))
+    {
+      ancestor_checks_walked++;
+      return TRUE;
+    }
+
+  ancestor_checks_rejected++;
+  return FALSE;
+}
+
 /* PSEUDOCLASS FOR STATE */
 
 static void
@@ -2177,6 +2264,16 @@ _gtk_css_selector_tree_match_all (const GtkCssSelectorTree *tree,
   return array;
 }
 
+void
+_gtk_css_selector_tree_get_stats (guint *rejected,
+                                  guint *walked)
+{
+  if (rejected)
+    *rejected = ancestor_checks_rejected;
+  if (walked)
+    *walked = ancestor_checks_walked;
+}
+
 GtkCssChange
 _gtk_css_selector_tree_get_change_all (const GtkCssSelectorTree *tree,
 				       const GtkCssMatcher *matcher)
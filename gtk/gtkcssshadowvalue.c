@@ -25,15 +25,13 @@
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkcssnumbervalueprivate.h"
 #include "gtkcssrgbavalueprivate.h"
+#include "gtkdebug.h"
 #include "gtkstylecontextprivate.h"
 #include "gtkthemingengineprivate.h"
 #include "gtkpango.h"
 
 #include <math.h>
-
-/* The blur of _gtk_cairo_blur_surface only approximately ends at radius,
-   so we add an extra pixel to make the clips less dramatic */
-#define CLIP_RADIUS_EXTRA 4
+#include <string.h>
 
 struct _GtkCssValue {
   GTK_CSS_VALUE_BASE
@@ -326,7 +324,7 @@ gtk_css_shadow_value_start_drawing (const GtkCssValue *shadow,
 
   gdk_cairo_get_clip_rectangle (cr, &clip_rect);
 
-  clip_radius = radius + CLIP_RADIUS_EXTRA;
+  clip_radius = _gtk_cairo_blur_compute_pixels (radius);
 
   /* Create a larger surface to center the blur. */
   surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
@@ -519,6 +517,341 @@ draw_shadow (const GtkCssValue   *shadow,
     gtk_css_shadow_value_finish_drawing (shadow, shadow_cr);
 }
 
+/* Blurred outset box shadows are cached as A8 masks. The blurred
+ * shadow of a box only depends on its corner radii and the blur
+ * radius, so the mask is rendered once for the smallest box with
+ * those corners in which the blurred corners don't touch. Larger
+ * boxes are painted from it in nine slices: the corners are copied
+ * and the middle row and column are stretched.
+ */
+#define SHADOW_MASK_CACHE_SIZE (4 * 1024 * 1024)
+
+typedef struct _GtkShadowMask GtkShadowMask;
+
+struct _GtkShadowMask {
+  GtkRoundedBoxCorner  corner[4];
+  double               radius;
+
+  cairo_surface_t     *surface;
+  int                  slice[4];  /* border slice sizes, indexed by GtkCssSide */
+  GList                link;
+};
+
+static GHashTable *shadow_masks = NULL;
+static GQueue shadow_mask_lru = G_QUEUE_INIT;
+static gsize shadow_mask_cache_size = 0;
+static guint shadow_mask_hits = 0;
+static guint shadow_mask_misses = 0;
+
+static guint
+gtk_shadow_mask_hash (gconstpointer data)
+{
+  const GtkShadowMask *mask = data;
+  guint i, hash;
+
+  hash = (guint) (mask->radius * 16);
+  for (i = 0; i < 4; i++)
+    {
+      hash = hash * 31 + (guint) (mask->corner[i].horizontal * 16);
+      hash = hash * 31 + (guint) (mask->corner[i].vertical * 16);
+    }
+
+  return hash;
+}
+
+static gboolean
+gtk_shadow_mask_equal (gconstpointer a,
+                       gconstpointer b)
+{
+  const GtkShadowMask *mask1 = a;
+  const GtkShadowMask *mask2 = b;
+  guint i;
+
+  if (mask1->radius != mask2->radius)
+    return FALSE;
+
+  for (i = 0; i < 4; i++)
+    {
+      if (mask1->corner[i].horizontal != mask2->corner[i].horizontal ||
+          mask1->corner[i].vertical != mask2->corner[i].vertical)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gsize
+gtk_shadow_mask_get_size (const GtkShadowMask *mask)
+{
+  return (mask->slice[GTK_CSS_LEFT] + 1 + mask->slice[GTK_CSS_RIGHT]) *
+         (mask->slice[GTK_CSS_TOP] + 1 + mask->slice[GTK_CSS_BOTTOM]);
+}
+
+static void
+gtk_shadow_mask_free (gpointer data)
+{
+  GtkShadowMask *mask = data;
+
+  if (mask->surface)
+    cairo_surface_destroy (mask->surface);
+
+  g_slice_free (GtkShadowMask, mask);
+}
+
+/* Sets the corners and slices of @mask for the box @box, which has
+ * to have integer coordinates. Returns %FALSE if @box is too small
+ * to be painted from a mask. */
+static gboolean
+gtk_shadow_mask_init (GtkShadowMask       *mask,
+                      const GtkRoundedBox *box,
+                      double               radius)
+{
+  int extent;
+
+  memcpy (mask->corner, box->corner, sizeof (mask->corner));
+  mask->radius = radius;
+  mask->surface = NULL;
+
+  extent = _gtk_cairo_blur_compute_pixels (radius);
+  mask->slice[GTK_CSS_TOP] = ceil (MAX (box->corner[GTK_CSS_TOP_LEFT].vertical,
+                                        box->corner[GTK_CSS_TOP_RIGHT].vertical)) + 2 * extent;
+  mask->slice[GTK_CSS_RIGHT] = ceil (MAX (box->corner[GTK_CSS_TOP_RIGHT].horizontal,
+                                          box->corner[GTK_CSS_BOTTOM_RIGHT].horizontal)) + 2 * extent;
+  mask->slice[GTK_CSS_BOTTOM] = ceil (MAX (box->corner[GTK_CSS_BOTTOM_LEFT].vertical,
+                                           box->corner[GTK_CSS_BOTTOM_RIGHT].vertical)) + 2 * extent;
+  mask->slice[GTK_CSS_LEFT] = ceil (MAX (box->corner[GTK_CSS_TOP_LEFT].horizontal,
+                                         box->corner[GTK_CSS_BOTTOM_LEFT].horizontal)) + 2 * extent;
+
+  /* The middle row and column must be out of reach of the corners,
+   * and the mask is painted grown by the extent on all sides. */
+  if (box->box.width + 2 * extent < mask->slice[GTK_CSS_LEFT] + 1 + mask->slice[GTK_CSS_RIGHT] ||
+      box->box.height + 2 * extent < mask->slice[GTK_CSS_TOP] + 1 + mask->slice[GTK_CSS_BOTTOM])
+    return FALSE;
+
+  /* Don't let a single huge shadow flush the whole cache */
+  if (gtk_shadow_mask_get_size (mask) > SHADOW_MASK_CACHE_SIZE / 4)
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gtk_shadow_mask_render (GtkShadowMask *mask)
+{
+  GtkRoundedBox box;
+  int width, height, extent;
+  cairo_t *cr;
+
+  extent = _gtk_cairo_blur_compute_pixels (mask->radius);
+  width = mask->slice[GTK_CSS_LEFT] + 1 + mask->slice[GTK_CSS_RIGHT];
+  height = mask->slice[GTK_CSS_TOP] + 1 + mask->slice[GTK_CSS_BOTTOM];
+
+  _gtk_rounded_box_init_rect (&box, extent, extent, width - 2 * extent, height - 2 * extent);
+  memcpy (box.corner, mask->corner, sizeof (box.corner));
+
+  mask->surface = cairo_image_surface_create (CAIRO_FORMAT_A8, width, height);
+  cr = cairo_create (mask->surface);
+  _gtk_rounded_box_path (&box, cr);
+  cairo_fill (cr);
+  cairo_destroy (cr);
+
+  _gtk_cairo_blur_surface (mask->surface, mask->radius);
+}
+
+static void
+gtk_shadow_mask_print_stats (void)
+{
+  guint total = shadow_mask_hits + shadow_mask_misses;
+
+  g_message ("shadow masks: %u cached, %" G_GSIZE_FORMAT " bytes, %u hits, %u misses (%.1f%% hit rate)",
+             g_queue_get_length (&shadow_mask_lru),
+             shadow_mask_cache_size,
+             shadow_mask_hits,
+             shadow_mask_misses,
+             100.0 * shadow_mask_hits / total);
+}
+
+static GtkShadowMask *
+gtk_shadow_mask_lookup (const GtkShadowMask *key)
+{
+  GtkShadowMask *mask;
+  GList *last;
+
+  if (shadow_masks == NULL)
+    shadow_masks = g_hash_table_new_full (gtk_shadow_mask_hash,
+                                          gtk_shadow_mask_equal,
+                                          gtk_shadow_mask_free,
+                                          NULL);
+
+  mask = g_hash_table_lookup (shadow_masks, key);
+  if (mask)
+    {
+      shadow_mask_hits++;
+      g_queue_unlink (&shadow_mask_lru, &mask->link);
+    }
+  else
+    {
+      shadow_mask_misses++;
+
+      mask = g_slice_dup (GtkShadowMask, key);
+      gtk_shadow_mask_render (mask);
+      mask->link.data = mask;
+      mask->link.prev = mask->link.next = NULL;
+      g_hash_table_add (shadow_masks, mask);
+      shadow_mask_cache_size += gtk_shadow_mask_get_size (mask);
+
+      while (shadow_mask_cache_size > SHADOW_MASK_CACHE_SIZE &&
+             !g_queue_is_empty (&shadow_mask_lru))
+        {
+          last = g_queue_pop_tail_link (&shadow_mask_lru);
+          shadow_mask_cache_size -= gtk_shadow_mask_get_size (last->data);
+          g_hash_table_remove (shadow_masks, last->data);
+        }
+    }
+
+  g_queue_push_head_link (&shadow_mask_lru, &mask->link);
+
+  if (G_UNLIKELY (gtk_get_debug_flags () & GTK_DEBUG_CSS_STATS) &&
+      (shadow_mask_hits + shadow_mask_misses) % 100 == 0)
+    gtk_shadow_mask_print_stats ();
+
+  return mask;
+}
+
+static void
+gtk_shadow_mask_paint_slice (GtkShadowMask *mask,
+                             cairo_t       *cr,
+                             int            src_x,
+                             int            src_y,
+                             int            src_width,
+                             int            src_height,
+                             int            dest_x,
+                             int            dest_y,
+                             int            dest_width,
+                             int            dest_height)
+{
+  cairo_surface_t *slice;
+  cairo_pattern_t *pattern;
+  cairo_matrix_t matrix;
+
+  if (dest_width <= 0 || dest_height <= 0)
+    return;
+
+  /* Padding a 1 pixel wide slice stretches it over the destination */
+  slice = cairo_surface_create_for_rectangle (mask->surface,
+                                              src_x, src_y,
+                                              src_width, src_height);
+  pattern = cairo_pattern_create_for_surface (slice);
+  cairo_pattern_set_extend (pattern, CAIRO_EXTEND_PAD);
+  cairo_matrix_init_translate (&matrix, -dest_x, -dest_y);
+  cairo_pattern_set_matrix (pattern, &matrix);
+
+  cairo_save (cr);
+  cairo_rectangle (cr, dest_x, dest_y, dest_width, dest_height);
+  cairo_clip (cr);
+  cairo_mask (cr, pattern);
+  cairo_restore (cr);
+
+  cairo_pattern_destroy (pattern);
+  cairo_surface_destroy (slice);
+}
+
+static gboolean
+is_integer (double value)
+{
+  return value == floor (value);
+}
+
+/* Paints the blurred outset shadow of @box from a cached mask. Returns
+ * %FALSE without painting anything if the shadow can't be painted
+ * exactly that way. */
+static gboolean
+draw_cached_shadow (const GtkCssValue   *shadow,
+                    cairo_t             *cr,
+                    const GtkRoundedBox *box,
+                    double               radius)
+{
+  GtkShadowMask key, *mask;
+  cairo_matrix_t matrix;
+  int src_offset[2][3], src_size[2][3];
+  int dest_offset[2][3], dest_size[2][3];
+  int x, y, width, height, extent;
+  int h, v;
+
+  /* The mask is only pixel exact when it is painted at whole pixels */
+  cairo_get_matrix (cr, &matrix);
+  if (matrix.xx != 1.0 || matrix.yx != 0.0 ||
+      matrix.xy != 0.0 || matrix.yy != 1.0 ||
+      !is_integer (matrix.x0) || !is_integer (matrix.y0) ||
+      !is_integer (box->box.x) || !is_integer (box->box.y) ||
+      !is_integer (box->box.width) || !is_integer (box->box.height))
+    return FALSE;
+
+  if (!gtk_shadow_mask_init (&key, box, radius))
+    return FALSE;
+
+  mask = gtk_shadow_mask_lookup (&key);
+
+  extent = _gtk_cairo_blur_compute_pixels (radius);
+  x = box->box.x - extent;
+  y = box->box.y - extent;
+  width = box->box.width + 2 * extent;
+  height = box->box.height + 2 * extent;
+
+  /* Index 0 is the horizontal axis, index 1 the vertical one */
+  src_offset[0][0] = 0;
+  src_offset[0][1] = mask->slice[GTK_CSS_LEFT];
+  src_offset[0][2] = mask->slice[GTK_CSS_LEFT] + 1;
+  src_size[0][0] = mask->slice[GTK_CSS_LEFT];
+  src_size[0][1] = 1;
+  src_size[0][2] = mask->slice[GTK_CSS_RIGHT];
+  dest_offset[0][0] = x;
+  dest_offset[0][1] = x + mask->slice[GTK_CSS_LEFT];
+  dest_offset[0][2] = x + width - mask->slice[GTK_CSS_RIGHT];
+  dest_size[0][0] = mask->slice[GTK_CSS_LEFT];
+  dest_size[0][1] = width - mask->slice[GTK_CSS_LEFT] - mask->slice[GTK_CSS_RIGHT];
+  dest_size[0][2] = mask->slice[GTK_CSS_RIGHT];
+
+  src_offset[1][0] = 0;
+  src_offset[1][1] = mask->slice[GTK_CSS_TOP];
+  src_offset[1][2] = mask->slice[GTK_CSS_TOP] + 1;
+  src_size[1][0] = mask->slice[GTK_CSS_TOP];
+  src_size[1][1] = 1;
+  src_size[1][2] = mask->slice[GTK_CSS_BOTTOM];
+  dest_offset[1][0] = y;
+  dest_offset[1][1] = y + mask->slice[GTK_CSS_TOP];
+  dest_offset[1][2] = y + height - mask->slice[GTK_CSS_BOTTOM];
+  dest_size[1][0] = mask->slice[GTK_CSS_TOP];
+  dest_size[1][1] = height - mask->slice[GTK_CSS_TOP] - mask->slice[GTK_CSS_BOTTOM];
+  dest_size[1][2] = mask->slice[GTK_CSS_BOTTOM];
+
+  gdk_cairo_set_source_rgba (cr, _gtk_css_rgba_value_get_rgba (shadow->color));
+
+  for (v = 0; v < 3; v++)
+    {
+      for (h = 0; h < 3; h++)
+        {
+          /* The middle of the mask is solid */
+          if (h == 1 && v == 1)
+            {
+              cairo_rectangle (cr,
+                               dest_offset[0][1], dest_offset[1][1],
+                               dest_size[0][1], dest_size[1][1]);
+              cairo_fill (cr);
+              continue;
+            }
+
+          gtk_shadow_mask_paint_slice (mask, cr,
+                                       src_offset[0][h], src_offset[1][v],
+                                       src_size[0][h], src_size[1][v],
+                                       dest_offset[0][h], dest_offset[1][v],
+                                       dest_size[0][h], dest_size[1][v]);
+        }
+    }
+
+  return TRUE;
+}
+
 void
 _gtk_css_shadow_value_paint_box (const GtkCssValue   *shadow,
                                  cairo_t             *cr,
@@ -533,7 +866,7 @@ _gtk_css_shadow_value_paint_box (const GtkCssValue   *shadow,
 
   spread = _gtk_css_number_value_get (shadow->spread, 0);
   radius = _gtk_css_number_value_get (shadow->radius, 0);
-  clip_radius = radius + CLIP_RADIUS_EXTRA;
+  clip_radius = _gtk_cairo_blur_compute_pixels (radius);
   x = _gtk_css_number_value_get (shadow->hoffset, 0);
   y = _gtk_css_number_value_get (shadow->voffset, 0);
 
@@ -574,7 +907,8 @@ _gtk_css_shadow_value_paint_box (const GtkCssValue   *shadow,
 
   if (radius == 0)
     draw_shadow (shadow, cr, &box, &clip_box, FALSE);
-  else
+  else if (shadow->inset ||
+           !draw_cached_shadow (shadow, cr, &box, radius))
     {
       int i, x1, x2, y1, y2;
       cairo_region_t *remaining;
@@ -50,7 +50,9 @@ typedef enum {
   GTK_DEBUG_SIZE_REQUEST    = 1 << 12,
   GTK_DEBUG_NO_CSS_CACHE    = 1 << 13,
   GTK_DEBUG_BASELINES       = 1 << 14,
-  GTK_DEBUG_PIXEL_CACHE     = 1 << 15
+  GTK_DEBUG_PIXEL_CACHE     = 1 << 15,
+  GTK_DEBUG_CSS_STATS       = 1 << 16,
+  GTK_DEBUG_SIZE_STATS      = 1 << 17
 } GtkDebugFlag;
 
 #ifdef G_ENABLE_DEBUG
@@ -503,6 +503,8 @@ gtk_entry_completion_init (GtkEntryCompletion *completion)
   priv->inline_selection = FALSE;
 
   priv->filter_model = NULL;
+  priv->normalized_items = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                  g_free, g_free);
 }
 
 static GObject *
@@ -657,6 +659,8 @@ gtk_entry_completion_set_property (GObject      *object,
 
       case PROP_TEXT_COLUMN:
         priv->text_column = g_value_get_int (value);
+        priv->refilter_full = TRUE;
+        g_hash_table_remove_all (priv->normalized_items);
         break;
 
       case PROP_INLINE_COMPLETION:
@@ -767,6 +771,7 @@ gtk_entry_completion_finalize (GObject *object)
 
   g_free (priv->case_normalized_key);
   g_free (priv->completion_prefix);
+  g_hash_table_destroy (priv->normalized_items);
 
   if (priv->match_notify)
     (* priv->match_notify) (priv->match_data);
@@ -840,6 +845,7 @@ gtk_entry_completion_default_completion_func (GtkEntryCompletion *completion,
                                               GtkTreeIter        *iter,
                                               gpointer            user_data)
 {
+  GtkEntryCompletionPrivate *priv = completion->priv;
   gchar *item = NULL;
   gchar *normalized_string;
   gchar *case_normalized_string;
@@ -848,35 +854,51 @@ gtk_entry_completion_default_completion_func (GtkEntryCompletion *completion,
 
   GtkTreeModel *model;
 
-  model = gtk_tree_model_filter_get_model (completion->priv->filter_model);
+  model = gtk_tree_model_filter_get_model (priv->filter_model);
 
-  g_return_val_if_fail (gtk_tree_model_get_column_type (model, completion->priv->text_column) == G_TYPE_STRING,
+  g_return_val_if_fail (gtk_tree_model_get_column_type (model, priv->text_column) == G_TYPE_STRING,
                         FALSE);
 
   gtk_tree_model_get (model, iter,
-                      completion->priv->text_column, &item,
+                      priv->text_column, &item,
                       -1);
 
   if (item != NULL)
     {
-      normalized_string = g_utf8_normalize (item, -1, G_NORMALIZE_ALL);
+      /* Normalizing is much more expensive than the lookup, and the
+       * same strings get matched again on every keypress.
+       */
+      case_normalized_string = g_hash_table_lookup (priv->normalized_items, item);
 
-      if (normalized_string != NULL)
+      if (case_normalized_string == NULL)
         {
-          case_normalized_string = g_utf8_casefold (normalized_string, -1);
-
-          if (!strncmp (key, case_normalized_string, strlen (key)))
-            ret = TRUE;
+          normalized_string = g_utf8_normalize (item, -1, G_NORMALIZE_ALL);
 
-          g_free (case_normalized_string);
+          if (normalized_string != NULL)
+            {
+              case_normalized_string = g_utf8_casefold (normalized_string, -1);
+              g_hash_table_insert (priv->normalized_items,
+                                   item, case_normalized_string);
+              item = NULL;
+            }
+          g_free (normalized_string);
         }
-      g_free (normalized_string);
+
+      if (case_normalized_string != NULL &&
+          !strncmp (key, case_normalized_string, strlen (key)))
+        ret = TRUE;
     }
   g_free (item);
 
   return ret;
 }
 
+static void
+gtk_entry_completion_clear_normalized_items (GtkEntryCompletion *completion)
+{
+  g_hash_table_remove_all (completion->priv->normalized_items);
+}
+
 static gboolean
 gtk_entry_completion_visible_func (GtkTreeModel *model,
                                    GtkTreeIter  *iter,
@@ -1131,6 +1153,13 @@ gtk_entry_completion_set_model (GtkEntryCompletion *completion,
   g_return_if_fail (GTK_IS_ENTRY_COMPLETION (completion));
   g_return_if_fail (model == NULL || GTK_IS_TREE_MODEL (model));
 
+  if (completion->priv->filter_model)
+    g_signal_handlers_disconnect_by_func (gtk_tree_model_filter_get_model (completion->priv->filter_model),
+                                          gtk_entry_completion_clear_normalized_items,
+                                          completion);
+
+  g_hash_table_remove_all (completion->priv->normalized_items);
+
   if (!model)
     {
       gtk_tree_view_set_model (GTK_TREE_VIEW (completion->priv->tree_view),
@@ -1148,6 +1177,14 @@ gtk_entry_completion_set_model (GtkEntryCompletion *completion,
                                           completion,
                                           NULL);
 
+  /* Rows that changed or went away leave stale strings behind */
+  g_signal_connect_object (model, "row-changed",
+                           G_CALLBACK (gtk_entry_completion_clear_normalized_items),
+                           completion, G_CONNECT_SWAPPED);
+  g_signal_connect_object (model, "row-deleted",
+                           G_CALLBACK (gtk_entry_completion_clear_normalized_items),
+                           completion, G_CONNECT_SWAPPED);
+
   gtk_tree_view_set_model (GTK_TREE_VIEW (completion->priv->tree_view),
                            GTK_TREE_MODEL (completion->priv->filter_model));
   g_object_unref (completion->priv->filter_model);
@@ -1208,6 +1245,7 @@ gtk_entry_completion_set_match_func (GtkEntryCompletion          *completion,
   completion->priv->match_func = func;
   completion->priv->match_data = func_data;
   completion->priv->match_notify = func_notify;
+  completion->priv->refilter_full = TRUE;
 }
 
 /**
@@ -1268,22 +1306,42 @@ gtk_entry_completion_get_minimum_key_length (GtkEntryCompletion *completion)
 void
 gtk_entry_completion_complete (GtkEntryCompletion *completion)
 {
+  GtkEntryCompletionPrivate *priv;
+  GtkTreeModelFilterChange change;
+  gchar *old_key;
   gchar *tmp;
 
   g_return_if_fail (GTK_IS_ENTRY_COMPLETION (completion));
   g_return_if_fail (GTK_IS_ENTRY (completion->priv->entry));
 
-  if (!completion->priv->filter_model)
+  priv = completion->priv;
+
+  if (!priv->filter_model)
     return;
 
-  g_free (completion->priv->case_normalized_key);
+  old_key = priv->case_normalized_key;
 
-  tmp = g_utf8_normalize (gtk_entry_get_text (GTK_ENTRY (completion->priv->entry)),
+  tmp = g_utf8_normalize (gtk_entry_get_text (GTK_ENTRY (priv->entry)),
                           -1, G_NORMALIZE_ALL);
-  completion->priv->case_normalized_key = g_utf8_casefold (tmp, -1);
+  priv->case_normalized_key = g_utf8_casefold (tmp, -1);
   g_free (tmp);
 
-  gtk_tree_model_filter_refilter (completion->priv->filter_model);
+  /* The default match function is a prefix match, so extending the
+   * key can only hide rows and shortening it can only show rows.
+   */
+  change = GTK_TREE_MODEL_FILTER_CHANGE_DIFFERENT;
+  if (old_key && !priv->match_func && !priv->refilter_full)
+    {
+      if (g_str_has_prefix (priv->case_normalized_key, old_key))
+        change = GTK_TREE_MODEL_FILTER_CHANGE_MORE_STRICT;
+      else if (g_str_has_prefix (old_key, priv->case_normalized_key))
+        change = GTK_TREE_MODEL_FILTER_CHANGE_LESS_STRICT;
+    }
+
+  g_free (old_key);
+  priv->refilter_full = FALSE;
+
+  gtk_tree_model_filter_refilter_with_change (priv->filter_model, change);
 
   if (gtk_widget_get_visible (completion->priv->popup_window))
     _gtk_entry_completion_resize_popup (completion);
@@ -1412,6 +1470,8 @@ gtk_entry_completion_set_text_column (GtkEntryCompletion *completion,
   g_return_if_fail (column >= 0);
 
   completion->priv->text_column = column;
+  completion->priv->refilter_full = TRUE;
+  g_hash_table_remove_all (completion->priv->normalized_items);
 
   cell = gtk_cell_renderer_text_new ();
   gtk_cell_layout_pack_start (GTK_CELL_LAYOUT (completion),
@@ -47,6 +47,11 @@ struct _GtkEntryCompletionPrivate
 
   gchar *case_normalized_key;
 
+  /* maps strings from the text column to their normalized,
+   * casefolded form, for the default match function
+   */
+  GHashTable *normalized_items;
+
   /* only used by GtkEntry when attached: */
   GtkWidget *popup_window;
   GtkWidget *vbox;
@@ -65,6 +70,7 @@ struct _GtkEntryCompletionPrivate
   guint popup_single_match : 1;
   guint inline_selection   : 1;
   guint has_grab           : 1;
+  guint refilter_full      : 1;
 
   gchar *completion_prefix;
 
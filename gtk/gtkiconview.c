@@ -156,6 +156,8 @@ static void             gtk_icon_view_size_allocate             (GtkWidget
 								 GtkAllocation      *allocation);
 static gboolean         gtk_icon_view_draw                      (GtkWidget          *widget,
                                                                  cairo_t            *cr);
+static void             gtk_icon_view_queue_draw_region         (GtkWidget            *widget,
+                                                                 const cairo_region_t *region);
 static gboolean         gtk_icon_view_motion                    (GtkWidget          *widget,
 								 GdkEventMotion     *event);
 static gboolean         gtk_icon_view_button_press              (GtkWidget          *widget,
@@ -359,6 +361,7 @@ gtk_icon_view_class_init (GtkIconViewClass *klass)
   widget_class->get_preferred_height_for_width = gtk_icon_view_get_preferred_height_for_width;
   widget_class->size_allocate = gtk_icon_view_size_allocate;
   widget_class->draw = gtk_icon_view_draw;
+  widget_class->queue_draw_region = gtk_icon_view_queue_draw_region;
   widget_class->motion_notify_event = gtk_icon_view_motion;
   widget_class->button_press_event = gtk_icon_view_button_press;
   widget_class->button_release_event = gtk_icon_view_button_release;
@@ -990,6 +993,8 @@ gtk_icon_view_init (GtkIconView *icon_view)
 
   icon_view->priv->draw_focus = TRUE;
 
+  icon_view->priv->pixel_cache = _gtk_pixel_cache_new ();
+
   icon_view->priv->row_contexts = 
     g_ptr_array_new_with_free_func ((GDestroyNotify)g_object_unref);
 
@@ -1242,6 +1247,41 @@ gtk_icon_view_get_property (GObject      *object,
 }
 
 /* GtkWidget methods */
+static void
+gtk_icon_view_bin_window_invalidate_handler (GdkWindow      *window,
+                                             cairo_region_t *region)
+{
+  gpointer widget;
+  GtkIconView *icon_view;
+
+  gdk_window_get_user_data (window, &widget);
+  icon_view = GTK_ICON_VIEW (widget);
+
+  /* The bin window covers the whole canvas, so the region
+     already is in the coordinates of the pixel cache */
+  if (icon_view->priv->pixel_cache)
+    _gtk_pixel_cache_invalidate (icon_view->priv->pixel_cache, region);
+}
+
+static void
+gtk_icon_view_queue_draw_region (GtkWidget            *widget,
+                                 const cairo_region_t *region)
+{
+  GtkIconView *icon_view = GTK_ICON_VIEW (widget);
+
+  /* There is no way we can know if a region targets the
+     not-currently-visible but in pixel cache region, so we
+     always just invalidate the whole thing whenever the
+     icon view gets a queue draw. Selection and prelight
+     changes only invalidate their items on the bin window
+     and don't end up here. */
+  if (icon_view->priv->pixel_cache)
+    _gtk_pixel_cache_invalidate (icon_view->priv->pixel_cache, NULL);
+
+  GTK_WIDGET_CLASS (gtk_icon_view_parent_class)->queue_draw_region (widget,
+                                                                    region);
+}
+
 static void
 gtk_icon_view_destroy (GtkWidget *widget)
 {
@@ -1269,6 +1309,10 @@ gtk_icon_view_destroy (GtkWidget *widget)
       icon_view->priv->vadjustment = NULL;
     }
 
+  if (icon_view->priv->pixel_cache)
+    _gtk_pixel_cache_free (icon_view->priv->pixel_cache);
+  icon_view->priv->pixel_cache = NULL;
+
   GTK_WIDGET_CLASS (gtk_icon_view_parent_class)->destroy (widget);
 }
 
@@ -1323,6 +1367,8 @@ gtk_icon_view_realize (GtkWidget *widget)
   icon_view->priv->bin_window = gdk_window_new (window,
 						&attributes, attributes_mask);
   gtk_widget_register_window (widget, icon_view->priv->bin_window);
+  gdk_window_set_invalidate_handler (icon_view->priv->bin_window,
+                                     gtk_icon_view_bin_window_invalidate_handler);
 
   context = gtk_widget_get_style_context (widget);
   gtk_style_context_set_background (context, icon_view->priv->bin_window);
@@ -1832,10 +1878,11 @@ gtk_icon_view_size_allocate (GtkWidget      *widget,
   g_object_thaw_notify (G_OBJECT (icon_view->priv->vadjustment));
 }
 
-static gboolean
-gtk_icon_view_draw (GtkWidget *widget,
-                    cairo_t   *cr)
+static void
+draw_bin (cairo_t  *cr,
+          gpointer  user_data)
 {
+  GtkWidget *widget = GTK_WIDGET (user_data);
   GtkIconView *icon_view;
   GList *icons;
   GtkTreePath *path;
@@ -1846,19 +1893,18 @@ gtk_icon_view_draw (GtkWidget *widget,
 
   icon_view = GTK_ICON_VIEW (widget);
 
-  context = gtk_widget_get_style_context (widget);
-  gtk_render_background (context, cr,
-                         0, 0,
-                         gtk_widget_get_allocated_width (widget),
-                         gtk_widget_get_allocated_height (widget));
-
-  if (!gtk_cairo_should_draw_window (cr, icon_view->priv->bin_window))
-    return FALSE;
-
   cairo_save (cr);
 
   gtk_cairo_transform_to_window (cr, widget, icon_view->priv->bin_window);
 
+  /* The pixel cache starts out cleared, not filled with
+   * the window background */
+  context = gtk_widget_get_style_context (widget);
+  gtk_render_background (context, cr,
+                         0, 0,
+                         gdk_window_get_width (icon_view->priv->bin_window),
+                         gdk_window_get_height (icon_view->priv->bin_window));
+
   cairo_set_line_width (cr, 1.);
 
   gtk_icon_view_get_drag_dest_item (icon_view, &path, &dest_pos);
@@ -1949,7 +1995,46 @@ gtk_icon_view_draw (GtkWidget *widget,
 
   cairo_restore (cr);
 
-  return GTK_WIDGET_CLASS (gtk_icon_view_parent_class)->draw (widget, cr);
+  /* Editable widgets of the cell area are drawn on the bin window
+   * and need to end up in the cache, too */
+  GTK_WIDGET_CLASS (gtk_icon_view_parent_class)->draw (widget, cr);
+}
+
+static gboolean
+gtk_icon_view_draw (GtkWidget *widget,
+                    cairo_t   *cr)
+{
+  GtkIconView *icon_view;
+  GtkStyleContext *context;
+
+  icon_view = GTK_ICON_VIEW (widget);
+
+  context = gtk_widget_get_style_context (widget);
+  gtk_render_background (context, cr,
+                         0, 0,
+                         gtk_widget_get_allocated_width (widget),
+                         gtk_widget_get_allocated_height (widget));
+
+  if (gtk_cairo_should_draw_window (cr, icon_view->priv->bin_window))
+    {
+      cairo_rectangle_int_t view_rect;
+      cairo_rectangle_int_t canvas_rect;
+
+      view_rect.x = 0;
+      view_rect.y = 0;
+      view_rect.width = gtk_widget_get_allocated_width (widget);
+      view_rect.height = gtk_widget_get_allocated_height (widget);
+
+      gdk_window_get_position (icon_view->priv->bin_window, &canvas_rect.x, &canvas_rect.y);
+      canvas_rect.width = gdk_window_get_width (icon_view->priv->bin_window);
+      canvas_rect.height = gdk_window_get_height (icon_view->priv->bin_window);
+
+      _gtk_pixel_cache_draw (icon_view->priv->pixel_cache, cr, icon_view->priv->bin_window,
+                             &view_rect, &canvas_rect,
+                             draw_bin, widget);
+    }
+
+  return FALSE;
 }
 
 static gboolean
@@ -16,6 +16,7 @@
  */
 
 #include "gtk/gtkiconview.h"
+#include "gtk/gtkpixelcacheprivate.h"
 
 #ifndef __GTK_ICON_VIEW_PRIVATE_H__
 #define __GTK_ICON_VIEW_PRIVATE_H__
@@ -51,6 +52,7 @@ struct _GtkIconViewPrivate
   GtkSelectionMode selection_mode;
 
   GdkWindow *bin_window;
+  GtkPixelCache *pixel_cache;
 
   GList *children;
 
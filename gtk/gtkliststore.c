@@ -571,14 +571,23 @@ gtk_list_store_set_column_type (GtkListStore *list_store,
   priv->column_headers[column] = type;
 }
 
+static void
+gtk_list_store_free_row (gpointer data,
+                         gpointer user_data)
+{
+  GtkListStore *list_store = user_data;
+  GtkListStorePrivate *priv = list_store->priv;
+
+  _gtk_tree_data_list_row_free (data, priv->n_columns, priv->column_headers);
+}
+
 static void
 gtk_list_store_finalize (GObject *object)
 {
   GtkListStore *list_store = GTK_LIST_STORE (object);
   GtkListStorePrivate *priv = list_store->priv;
 
-  g_sequence_foreach (priv->seq,
-		      (GFunc) _gtk_tree_data_list_free, priv->column_headers);
+  g_sequence_foreach (priv->seq, gtk_list_store_free_row, list_store);
 
   g_sequence_free (priv->seq);
 
@@ -684,21 +693,17 @@ gtk_list_store_get_value (GtkTreeModel *tree_model,
 {
   GtkListStore *list_store = GTK_LIST_STORE (tree_model);
   GtkListStorePrivate *priv = list_store->priv;
-  GtkTreeDataList *list;
-  gint tmp_column = column;
+  GtkTreeDataList *row;
 
   g_return_if_fail (column < priv->n_columns);
   g_return_if_fail (iter_is_valid (iter, list_store));
 		    
-  list = g_sequence_get (iter->user_data);
-
-  while (tmp_column-- > 0 && list)
-    list = list->next;
+  row = g_sequence_get (iter->user_data);
 
-  if (list == NULL)
+  if (row == NULL)
     g_value_init (value, priv->column_headers[column]);
   else
-    _gtk_tree_data_list_node_to_value (list,
+    _gtk_tree_data_list_node_to_value (&row[column],
 				       priv->column_headers[column],
 				       value);
 }
@@ -834,9 +839,7 @@ gtk_list_store_real_set_value (GtkListStore *list_store,
 			       gboolean      sort)
 {
   GtkListStorePrivate *priv = list_store->priv;
-  GtkTreeDataList *list;
-  GtkTreeDataList *prev;
-  gint old_column = column;
+  GtkTreeDataList *row;
   GValue real_value = G_VALUE_INIT;
   gboolean converted = FALSE;
   gboolean retval = FALSE;
@@ -865,60 +868,25 @@ gtk_list_store_real_set_value (GtkListStore *list_store,
       converted = TRUE;
     }
 
-  prev = list = g_sequence_get (iter->user_data);
-
-  while (list != NULL)
-    {
-      if (column == 0)
-	{
-	  if (converted)
-	    _gtk_tree_data_list_value_to_node (list, &real_value);
-	  else
-	    _gtk_tree_data_list_value_to_node (list, value);
-	  retval = TRUE;
-	  if (converted)
-	    g_value_unset (&real_value);
-         if (sort && GTK_LIST_STORE_IS_SORTED (list_store))
-            gtk_list_store_sort_iter_changed (list_store, iter, old_column);
-	  return retval;
-	}
-
-      column--;
-      prev = list;
-      list = list->next;
-    }
-
-  if (g_sequence_get (iter->user_data) == NULL)
-    {
-      list = _gtk_tree_data_list_alloc();
-      g_sequence_set (iter->user_data, list);
-      list->next = NULL;
-    }
-  else
-    {
-      list = prev->next = _gtk_tree_data_list_alloc ();
-      list->next = NULL;
-    }
+  row = g_sequence_get (iter->user_data);
 
-  while (column != 0)
+  if (row == NULL)
     {
-      list->next = _gtk_tree_data_list_alloc ();
-      list = list->next;
-      list->next = NULL;
-      column --;
+      row = _gtk_tree_data_list_row_new (priv->n_columns);
+      g_sequence_set (iter->user_data, row);
     }
 
   if (converted)
-    _gtk_tree_data_list_value_to_node (list, &real_value);
+    _gtk_tree_data_list_value_to_node (&row[column], &real_value);
   else
-    _gtk_tree_data_list_value_to_node (list, value);
+    _gtk_tree_data_list_value_to_node (&row[column], value);
 
   retval = TRUE;
   if (converted)
     g_value_unset (&real_value);
 
   if (sort && GTK_LIST_STORE_IS_SORTED (list_store))
-    gtk_list_store_sort_iter_changed (list_store, iter, old_column);
+    gtk_list_store_sort_iter_changed (list_store, iter, column);
 
   return retval;
 }
@@ -1225,7 +1193,8 @@ gtk_list_store_remove (GtkListStore *list_store,
   ptr = iter->user_data;
   next = g_sequence_iter_next (ptr);
   
-  _gtk_tree_data_list_free (g_sequence_get (ptr), priv->column_headers);
+  _gtk_tree_data_list_row_free (g_sequence_get (ptr),
+                                priv->n_columns, priv->column_headers);
   g_sequence_remove (iter->user_data);
 
   priv->length--;
@@ -1580,33 +1549,15 @@ gtk_list_store_drag_data_received (GtkTreeDragDest   *drag_dest,
        */
       if (retval)
         {
-          GtkTreeDataList *dl = g_sequence_get (src_iter.user_data);
-          GtkTreeDataList *copy_head = NULL;
-          GtkTreeDataList *copy_prev = NULL;
-          GtkTreeDataList *copy_iter = NULL;
+          GtkTreeDataList *row;
 	  GtkTreePath *path;
-          gint col;
-
-          col = 0;
-          while (dl)
-            {
-              copy_iter = _gtk_tree_data_list_node_copy (dl,
-                                                         priv->column_headers[col]);
-
-              if (copy_head == NULL)
-                copy_head = copy_iter;
-
-              if (copy_prev)
-                copy_prev->next = copy_iter;
 
-              copy_prev = copy_iter;
-
-              dl = dl->next;
-              ++col;
-            }
+          row = _gtk_tree_data_list_row_copy (g_sequence_get (src_iter.user_data),
+                                              priv->n_columns,
+                                              priv->column_headers);
 
 	  dest_iter.stamp = priv->stamp;
-          g_sequence_set (dest_iter.user_data, copy_head);
+          g_sequence_set (dest_iter.user_data, row);
 
 	  path = gtk_list_store_get_path (tree_model, &dest_iter);
 	  gtk_tree_model_row_changed (tree_model, path, &dest_iter);
@@ -1949,15 +1900,35 @@ gtk_list_store_compare_func (GSequenceIter *a,
       data = priv->default_sort_data;
     }
 
-  iter_a.stamp = priv->stamp;
-  iter_a.user_data = (gpointer)a;
-  iter_b.stamp = priv->stamp;
-  iter_b.user_data = (gpointer)b;
+  if (func == _gtk_tree_data_list_compare_func)
+    {
+      /* Compare the stored values directly instead of copying
+       * them into GValues. Rows that have never been set hold
+       * the default value, which is all zeros.
+       */
+      static const GtkTreeDataList zero_node;
+      GtkTreeDataList *row_a, *row_b;
+      gint column = GPOINTER_TO_INT (data);
+
+      row_a = g_sequence_get (a);
+      row_b = g_sequence_get (b);
 
-  g_assert (iter_is_valid (&iter_a, list_store));
-  g_assert (iter_is_valid (&iter_b, list_store));
+      retval = _gtk_tree_data_list_node_compare (row_a ? &row_a[column] : (GtkTreeDataList *) &zero_node,
+                                                 row_b ? &row_b[column] : (GtkTreeDataList *) &zero_node,
+                                                 priv->column_headers[column]);
+    }
+  else
+    {
+      iter_a.stamp = priv->stamp;
+      iter_a.user_data = (gpointer)a;
+      iter_b.stamp = priv->stamp;
+      iter_b.user_data = (gpointer)b;
 
-  retval = (* func) (GTK_TREE_MODEL (list_store), &iter_a, &iter_b, data);
+      g_assert (iter_is_valid (&iter_a, list_store));
+      g_assert (iter_is_valid (&iter_b, list_store));
+
+      retval = (* func) (GTK_TREE_MODEL (list_store), &iter_a, &iter_b, data);
+    }
 
   if (priv->order == GTK_SORT_DESCENDING)
     {
@@ -2330,6 +2301,110 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/**
+ * gtk_list_store_insert_rows_from_arrays: (skip)
+ * @list_store: A #GtkListStore
+ * @position: position to insert the new rows, or -1 to append them
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_columns): an array of column numbers
+ * @values: (array length=n_columns): an array of arrays of #GValues.
+ *     @values[i] holds the @n_rows values for column @columns[i],
+ *     one per new row
+ * @n_columns: the length of the @columns and @values arrays
+ *
+ * Inserts @n_rows new rows at @position and fills the given
+ * columns from @values. Columns that aren't listed are left unset.
+ *
+ * The result is the same as calling gtk_list_store_insert_with_valuesv()
+ * once for every row, with increasing positions, and a
+ * #GtkTreeModel::row-inserted signal is emitted for every row. It is
+ * considerably faster for large numbers of rows though, since the
+ * arguments are checked and the need to sort is determined only once.
+ *
+ * Since: 3.10
+ */
+void
+gtk_list_store_insert_rows_from_arrays (GtkListStore  *list_store,
+                                        gint           position,
+                                        gint           n_rows,
+                                        gint          *columns,
+                                        GValue       **values,
+                                        gint           n_columns)
+{
+  GtkListStorePrivate *priv;
+  GtkTreeIterCompareFunc func;
+  GtkTreePath *path;
+  GSequenceIter *ptr;
+  GtkTreeIter iter;
+  gboolean maybe_need_sort;
+  gint length, pos, i, j;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_columns == 0 || (columns != NULL && values != NULL));
+
+  priv = list_store->priv;
+
+  for (j = 0; j < n_columns; j++)
+    g_return_if_fail (columns[j] >= 0 && columns[j] < priv->n_columns);
+
+  if (n_rows == 0)
+    return;
+
+  priv->columns_dirty = TRUE;
+
+  /* Like gtk_list_store_set_vector_internal(), but only once */
+  maybe_need_sort = FALSE;
+  func = gtk_list_store_get_compare_func (list_store);
+  if (func != _gtk_tree_data_list_compare_func)
+    maybe_need_sort = TRUE;
+  for (j = 0; j < n_columns; j++)
+    {
+      if (func == _gtk_tree_data_list_compare_func &&
+          columns[j] == priv->sort_column_id)
+        maybe_need_sort = TRUE;
+    }
+  maybe_need_sort = maybe_need_sort && GTK_LIST_STORE_IS_SORTED (list_store);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      /* Look up the insertion point for every row, row-inserted
+       * handlers may have changed the store in the meantime */
+      length = g_sequence_get_length (priv->seq);
+      if (position < 0 || position + i > length)
+        pos = length;
+      else
+        pos = position + i;
+
+      ptr = g_sequence_get_iter_at_pos (priv->seq, pos);
+
+      iter.stamp = priv->stamp;
+      iter.user_data = g_sequence_insert_before (ptr, NULL);
+      priv->length++;
+
+      for (j = 0; j < n_columns; j++)
+        gtk_list_store_real_set_value (list_store,
+                                       &iter,
+                                       columns[j],
+                                       &values[j][i],
+                                       FALSE);
+
+      if (maybe_need_sort)
+        {
+          /* Sorted rows don't end up next to each other */
+          g_sequence_sort_changed_iter (iter.user_data,
+                                        gtk_list_store_compare_func,
+                                        list_store);
+          path = gtk_list_store_get_path (GTK_TREE_MODEL (list_store), &iter);
+        }
+      else
+        path = gtk_tree_path_new_from_indices (pos, -1);
+
+      gtk_tree_model_row_inserted (GTK_TREE_MODEL (list_store), path, &iter);
+      gtk_tree_path_free (path);
+    }
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
@@ -122,6 +122,13 @@ void          gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
 						  gint         *columns,
 						  GValue       *values,
 						  gint          n_values);
+GDK_AVAILABLE_IN_3_10
+void          gtk_list_store_insert_rows_from_arrays (GtkListStore  *list_store,
+                                                      gint           position,
+                                                      gint           n_rows,
+                                                      gint          *columns,
+                                                      GValue       **values,
+                                                      gint           n_columns);
 GDK_AVAILABLE_IN_ALL
 void          gtk_list_store_prepend          (GtkListStore *list_store,
 					       GtkTreeIter  *iter);
@@ -173,7 +173,9 @@ static const GDebugKey gtk_debug_keys[] = {
   {"size-request", GTK_DEBUG_SIZE_REQUEST},
   {"no-css-cache", GTK_DEBUG_NO_CSS_CACHE},
   {"baselines", GTK_DEBUG_BASELINES},
-  {"pixel-cache", GTK_DEBUG_PIXEL_CACHE}
+  {"pixel-cache", GTK_DEBUG_PIXEL_CACHE},
+  {"css-stats", GTK_DEBUG_CSS_STATS},
+  {"size-stats", GTK_DEBUG_SIZE_STATS}
 };
 #endif /* G_ENABLE_DEBUG */
 
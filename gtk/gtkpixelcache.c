@@ -22,39 +22,109 @@
 
 #define BLOW_CACHE_TIMEOUT_SEC 20
 
-/* The extra size of the offscreen surface we allocate
-   to make scrolling more efficient */
+/* The cache is a grid of tiles of this size, in canvas
+   coordinates */
+#define TILE_SIZE 256
+
+/* Tiles that are at most this far outside the view are
+   kept around to make scrolling more efficient */
 #define EXTRA_SIZE 64
 
-/* When resizing viewport to smaller we allow this extra
-   size to avoid constantly reallocating when resizing */
-#define ALLOW_LARGER_SIZE 32
+/* Number of tile surfaces that are kept for reuse when
+   tiles leave the view */
+#define MAX_FREE_SURFACES 8
+
+typedef struct {
+  /* Position of the tile in canvas coordinates */
+  int x;
+  int y;
 
-struct _GtkPixelCache {
   cairo_surface_t *surface;
 
-  /* Valid if surface != NULL */
-  int surface_x;
-  int surface_y;
-  int surface_w;
-  int surface_h;
+  /* In tile coordinates, may be null if not dirty */
+  cairo_region_t *dirty;
+} GtkPixelCacheTile;
 
-  /* may be null if not dirty */
-  cairo_region_t *surface_dirty;
+struct _GtkPixelCache {
+  GHashTable *tiles;
+
+  /* Unused tile surfaces, all of them with the content
+     of the tiles */
+  GPtrArray *free_surfaces;
+  cairo_content_t content;
+
+  /* The area of the canvas that was drawn into tiles,
+     used to invalidate what becomes visible when the
+     canvas grows */
+  int area_w;
+  int area_h;
 
   guint timeout_tag;
 };
 
+/* Start of the tile containing the canvas coordinate v */
+static inline int
+tile_start (int v)
+{
+  if (v >= 0)
+    return v - v % TILE_SIZE;
+  else
+    return v - (TILE_SIZE + v % TILE_SIZE) % TILE_SIZE;
+}
+
+static guint
+tile_hash (gconstpointer key)
+{
+  const GtkPixelCacheTile *tile = key;
+
+  return (guint) (tile->x / TILE_SIZE) ^ ((guint) (tile->y / TILE_SIZE) << 16);
+}
+
+static gboolean
+tile_equal (gconstpointer a,
+            gconstpointer b)
+{
+  const GtkPixelCacheTile *tile_a = a;
+  const GtkPixelCacheTile *tile_b = b;
+
+  return tile_a->x == tile_b->x && tile_a->y == tile_b->y;
+}
+
+static void
+tile_free (gpointer data)
+{
+  GtkPixelCacheTile *tile = data;
+
+  if (tile->surface != NULL)
+    cairo_surface_destroy (tile->surface);
+
+  if (tile->dirty != NULL)
+    cairo_region_destroy (tile->dirty);
+
+  g_slice_free (GtkPixelCacheTile, tile);
+}
+
 GtkPixelCache *
 _gtk_pixel_cache_new ()
 {
   GtkPixelCache *cache;
 
   cache = g_new0 (GtkPixelCache, 1);
+  cache->tiles = g_hash_table_new_full (tile_hash, tile_equal, tile_free, NULL);
+  cache->free_surfaces = g_ptr_array_new_with_free_func ((GDestroyNotify) cairo_surface_destroy);
 
   return cache;
 }
 
+static void
+_gtk_pixel_cache_clear (GtkPixelCache *cache)
+{
+  g_hash_table_remove_all (cache->tiles);
+  g_ptr_array_set_size (cache->free_surfaces, 0);
+  cache->area_w = 0;
+  cache->area_h = 0;
+}
+
 void
 _gtk_pixel_cache_free (GtkPixelCache *cache)
 {
@@ -64,78 +134,153 @@ _gtk_pixel_cache_free (GtkPixelCache *cache)
   if (cache->timeout_tag)
     g_source_remove (cache->timeout_tag);
 
-  if (cache->surface != NULL)
-    cairo_surface_destroy (cache->surface);
-
-  if (cache->surface_dirty != NULL)
-    cairo_region_destroy (cache->surface_dirty);
+  g_hash_table_destroy (cache->tiles);
+  g_ptr_array_unref (cache->free_surfaces);
 
   g_free (cache);
 }
 
+static void
+_gtk_pixel_cache_tile_invalidate (GtkPixelCacheTile *tile,
+                                  cairo_region_t    *region)
+{
+  cairo_rectangle_int_t r;
+
+  r.x = 0;
+  r.y = 0;
+  r.width = TILE_SIZE;
+  r.height = TILE_SIZE;
+
+  if (region == NULL)
+    {
+      if (tile->dirty != NULL)
+        cairo_region_destroy (tile->dirty);
+      tile->dirty = cairo_region_create_rectangle (&r);
+      return;
+    }
+
+  cairo_region_translate (region, -tile->x, -tile->y);
+
+  if (tile->dirty == NULL)
+    {
+      tile->dirty = cairo_region_copy (region);
+      cairo_region_intersect_rectangle (tile->dirty, &r);
+    }
+  else
+    {
+      cairo_region_union (tile->dirty, region);
+      cairo_region_intersect_rectangle (tile->dirty, &r);
+    }
+
+  cairo_region_translate (region, tile->x, tile->y);
+}
+
 /* Region is in canvas coordinates */
 void
 _gtk_pixel_cache_invalidate (GtkPixelCache *cache,
 			     cairo_region_t *region)
 {
-  cairo_rectangle_int_t r;
-  cairo_region_t *free_region = NULL;
+  cairo_rectangle_int_t extents;
+  GHashTableIter iter;
+  GtkPixelCacheTile *tile;
 
-  if (cache->surface == NULL ||
-      (region != NULL && cairo_region_is_empty (region)))
+  if (region != NULL && cairo_region_is_empty (region))
     return;
 
-  if (region == NULL)
-    {
-      r.x = cache->surface_x;
-      r.y = cache->surface_y;
-      r.width = cache->surface_w;
-      r.height = cache->surface_h;
+  if (region != NULL)
+    cairo_region_get_extents (region, &extents);
 
-      free_region = region =
-	cairo_region_create_rectangle (&r);
+  g_hash_table_iter_init (&iter, cache->tiles);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &tile, NULL))
+    {
+      if (region != NULL &&
+          (extents.x >= tile->x + TILE_SIZE ||
+           extents.x + extents.width <= tile->x ||
+           extents.y >= tile->y + TILE_SIZE ||
+           extents.y + extents.height <= tile->y))
+        continue;
+
+      _gtk_pixel_cache_tile_invalidate (tile, region);
     }
+}
+
+/* Drops the tiles outside of keep_rect, the surfaces
+   are kept for the tiles that become visible */
+static void
+_gtk_pixel_cache_recycle_tiles (GtkPixelCache         *cache,
+                                cairo_rectangle_int_t *keep_rect)
+{
+  GHashTableIter iter;
+  GtkPixelCacheTile *tile;
 
-  if (cache->surface_dirty == NULL)
+  g_hash_table_iter_init (&iter, cache->tiles);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &tile, NULL))
     {
-      cache->surface_dirty = cairo_region_copy (region);
-      cairo_region_translate (cache->surface_dirty,
-			      -cache->surface_x,
-			      -cache->surface_y);
+      if (tile->x < keep_rect->x + keep_rect->width &&
+          tile->x + TILE_SIZE > keep_rect->x &&
+          tile->y < keep_rect->y + keep_rect->height &&
+          tile->y + TILE_SIZE > keep_rect->y)
+        continue;
+
+      if (cache->free_surfaces->len < MAX_FREE_SURFACES)
+        {
+          g_ptr_array_add (cache->free_surfaces, tile->surface);
+          tile->surface = NULL;
+        }
+
+      g_hash_table_iter_remove (&iter);
     }
+}
+
+static GtkPixelCacheTile *
+_gtk_pixel_cache_ensure_tile (GtkPixelCache *cache,
+                              GdkWindow     *window,
+                              int            x,
+                              int            y)
+{
+  GtkPixelCacheTile key, *tile;
+
+  key.x = x;
+  key.y = y;
+
+  tile = g_hash_table_lookup (cache->tiles, &key);
+  if (tile != NULL)
+    return tile;
+
+  tile = g_slice_new (GtkPixelCacheTile);
+  tile->x = x;
+  tile->y = y;
+  tile->dirty = NULL;
+
+  if (cache->free_surfaces->len > 0)
+    tile->surface = g_ptr_array_remove_index_fast (cache->free_surfaces,
+                                                   cache->free_surfaces->len - 1);
   else
-    {
-      cairo_region_translate (region,
-			      -cache->surface_x,
-			      -cache->surface_y);
-      cairo_region_union (cache->surface_dirty, region);
-      cairo_region_translate (region,
-			      cache->surface_x,
-			      cache->surface_y);
-    }
+    tile->surface = gdk_window_create_similar_surface (window, cache->content,
+                                                       TILE_SIZE, TILE_SIZE);
 
-  if (free_region)
-    cairo_region_destroy (free_region);
+  _gtk_pixel_cache_tile_invalidate (tile, NULL);
 
-  r.x = 0;
-  r.y = 0;
-  r.width = cache->surface_w;
-  r.height = cache->surface_h;
+  g_hash_table_add (cache->tiles, tile);
 
-  cairo_region_intersect_rectangle (cache->surface_dirty, &r);
+  return tile;
 }
 
+/* Makes sure all of view_pos is covered by tiles and throws
+   away the tiles that are too far away from it */
 static void
-_gtk_pixel_cache_create_surface_if_needed (GtkPixelCache         *cache,
-					   GdkWindow             *window,
-					   cairo_rectangle_int_t *view_rect,
-					   cairo_rectangle_int_t *canvas_rect)
+_gtk_pixel_cache_update_tiles (GtkPixelCache         *cache,
+                               GdkWindow             *window,
+                               cairo_rectangle_int_t *view_rect,
+                               cairo_rectangle_int_t *canvas_rect,
+                               cairo_rectangle_int_t *view_pos)
 {
-  cairo_rectangle_int_t rect;
-  int surface_w, surface_h;
+  cairo_rectangle_int_t keep_rect, r;
   cairo_content_t content;
   cairo_pattern_t *bg;
   double red, green, blue, alpha;
+  int area_w, area_h;
+  int x, y;
 
   content = CAIRO_CONTENT_COLOR_ALPHA;
   bg = gdk_window_get_background_pattern (window);
@@ -145,188 +290,230 @@ _gtk_pixel_cache_create_surface_if_needed (GtkPixelCache         *cache,
       alpha == 1.0)
     content = CAIRO_CONTENT_COLOR;
 
-  surface_w = view_rect->width;
-  if (canvas_rect->width > surface_w)
-    surface_w = MIN (surface_w + EXTRA_SIZE, canvas_rect->width);
-
-  surface_h = view_rect->height;
-  if (canvas_rect->height > surface_h)
-    surface_h = MIN (surface_h + EXTRA_SIZE, canvas_rect->height);
-
-  /* If current surface can't fit view_rect or is too large, kill it */
-  if (cache->surface != NULL &&
-      (cairo_surface_get_content (cache->surface) != content ||
-       cache->surface_w < view_rect->width ||
-       cache->surface_w > surface_w + ALLOW_LARGER_SIZE ||
-       cache->surface_h < view_rect->height ||
-       cache->surface_h > surface_h + ALLOW_LARGER_SIZE))
+  if (content != cache->content)
     {
-      cairo_surface_destroy (cache->surface);
-      cache->surface = NULL;
-      if (cache->surface_dirty)
-	cairo_region_destroy (cache->surface_dirty);
-      cache->surface_dirty = NULL;
+      _gtk_pixel_cache_clear (cache);
+      cache->content = content;
     }
 
-  /* Don't allocate a surface if view >= canvas, as we won't
-     be scrolling then anyway */
-  if (cache->surface == NULL &&
-      (view_rect->width < canvas_rect->width ||
-       view_rect->height < canvas_rect->height))
+  /* What is drawn is the canvas, or the view if it is larger */
+  area_w = MAX (canvas_rect->width, view_rect->width);
+  area_h = MAX (canvas_rect->height, view_rect->height);
+
+  /* Parts that became part of the area were never drawn */
+  if ((area_w > cache->area_w || area_h > cache->area_h) &&
+      g_hash_table_size (cache->tiles) > 0)
+    {
+      cairo_region_t *region;
+
+      r.x = 0;
+      r.y = 0;
+      r.width = area_w;
+      r.height = area_h;
+      region = cairo_region_create_rectangle (&r);
+
+      r.width = cache->area_w;
+      r.height = cache->area_h;
+      cairo_region_subtract_rectangle (region, &r);
+
+      _gtk_pixel_cache_invalidate (cache, region);
+      cairo_region_destroy (region);
+    }
+  cache->area_w = area_w;
+  cache->area_h = area_h;
+
+  keep_rect = *view_pos;
+  if (canvas_rect->width > view_rect->width)
+    {
+      keep_rect.x -= EXTRA_SIZE;
+      keep_rect.width += 2 * EXTRA_SIZE;
+    }
+  if (canvas_rect->height > view_rect->height)
+    {
+      keep_rect.y -= EXTRA_SIZE;
+      keep_rect.height += 2 * EXTRA_SIZE;
+    }
+
+  _gtk_pixel_cache_recycle_tiles (cache, &keep_rect);
+
+  for (y = tile_start (view_pos->y);
+       y < view_pos->y + view_pos->height;
+       y += TILE_SIZE)
     {
-      cache->surface_x = -canvas_rect->x;
-      cache->surface_y = -canvas_rect->y;
-      cache->surface_w = surface_w;
-      cache->surface_h = surface_h;
-
-      cache->surface =
-	gdk_window_create_similar_surface (window, content,
-					   surface_w, surface_h);
-      rect.x = 0;
-      rect.y = 0;
-      rect.width = surface_w;
-      rect.height = surface_h;
-      cache->surface_dirty =
-	cairo_region_create_rectangle (&rect);
+      for (x = tile_start (view_pos->x);
+           x < view_pos->x + view_pos->width;
+           x += TILE_SIZE)
+        _gtk_pixel_cache_ensure_tile (cache, window, x, y);
     }
 }
 
-void
-_gtk_pixel_cache_set_position (GtkPixelCache         *cache,
-			       cairo_rectangle_int_t *view_rect,
-			       cairo_rectangle_int_t *canvas_rect)
+static void
+_gtk_pixel_cache_debug_tint (cairo_t *cr)
 {
-  cairo_rectangle_int_t r, view_pos;
-  cairo_region_t *copy_region;
-  int new_surf_x, new_surf_y;
-  cairo_t *backing_cr;
+#ifdef G_ENABLE_DEBUG
+  if (gtk_get_debug_flags () & GTK_DEBUG_PIXEL_CACHE)
+    {
+      GdkRGBA colors[] = {
+        { 1, 0, 0, 0.08},
+        { 0, 1, 0, 0.08},
+        { 0, 0, 1, 0.08},
+        { 1, 0, 1, 0.08},
+        { 1, 1, 0, 0.08},
+        { 0, 1, 1, 0.08},
+      };
+      static int current_color = 0;
+
+      gdk_cairo_set_source_rgba (cr, &colors[(current_color++) % G_N_ELEMENTS (colors)]);
+      cairo_paint (cr);
+    }
+#endif
+}
 
-  if (cache->surface == NULL)
-    return;
+/* Clears the clip area of cr and draws the canvas into it, cr
+   must be in canvas coordinates */
+static void
+_gtk_pixel_cache_paint (cairo_t               *cr,
+                        GtkPixelCacheDrawFunc  draw,
+                        cairo_rectangle_int_t *view_rect,
+                        cairo_rectangle_int_t *canvas_rect,
+                        gpointer               user_data)
+{
+  cairo_translate (cr,
+                   -canvas_rect->x - view_rect->x,
+                   -canvas_rect->y - view_rect->y);
+  cairo_set_source_rgba (cr, 0.0, 0, 0, 0.0);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_paint (cr);
 
-  /* Position of view inside canvas */
-  view_pos.x = -canvas_rect->x;
-  view_pos.y = -canvas_rect->y;
-  view_pos.width = view_rect->width;
-  view_pos.height = view_rect->height;
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
 
-  /* Reposition so all is visible */
-  if (view_pos.x < cache->surface_x ||
-      view_pos.x + view_pos.width >
-      cache->surface_x + cache->surface_w ||
-      view_pos.y < cache->surface_y ||
-      view_pos.y + view_pos.height >
-      cache->surface_y + cache->surface_h)
-    {
-      new_surf_x = cache->surface_x;
-      if (view_pos.x < cache->surface_x)
-	new_surf_x = MAX (view_pos.x + view_pos.width - cache->surface_w, 0);
-      else if (view_pos.x + view_pos.width >
-	       cache->surface_x + cache->surface_w)
-	new_surf_x = MIN (view_pos.x, canvas_rect->width - cache->surface_w);
-
-      new_surf_y = cache->surface_y;
-      if (view_pos.y < cache->surface_y)
-	new_surf_y = MAX (view_pos.y + view_pos.height - cache->surface_h, 0);
-      else if (view_pos.y + view_pos.height >
-	       cache->surface_y + cache->surface_h)
-	new_surf_y = MIN (view_pos.y, canvas_rect->height - cache->surface_h);
+  cairo_save (cr);
+  draw (cr, user_data);
+  cairo_restore (cr);
 
-      r.x = 0;
-      r.y = 0;
-      r.width = cache->surface_w;
-      r.height = cache->surface_h;
-      copy_region = cairo_region_create_rectangle (&r);
-
-      if (cache->surface_dirty)
-	{
-	  cairo_region_subtract (copy_region, cache->surface_dirty);
-	  cairo_region_destroy (cache->surface_dirty);
-	  cache->surface_dirty = NULL;
-	}
-
-      cairo_region_translate (copy_region,
-			      cache->surface_x - new_surf_x,
-			      cache->surface_y - new_surf_y);
-      cairo_region_intersect_rectangle (copy_region, &r);
-
-      backing_cr = cairo_create (cache->surface);
-      gdk_cairo_region (backing_cr, copy_region);
-      cairo_set_operator (backing_cr, CAIRO_OPERATOR_SOURCE);
-      cairo_clip (backing_cr);
-      cairo_push_group (backing_cr);
-      cairo_set_source_surface (backing_cr, cache->surface,
-				cache->surface_x - new_surf_x,
-				cache->surface_y - new_surf_y);
-      cairo_paint (backing_cr);
-      cairo_pop_group_to_source (backing_cr);
-      cairo_paint (backing_cr);
-      cairo_destroy (backing_cr);
-
-      cache->surface_x = new_surf_x;
-      cache->surface_y = new_surf_y;
-
-      cairo_region_xor_rectangle (copy_region, &r);
-      cache->surface_dirty = copy_region;
-    }
+  _gtk_pixel_cache_debug_tint (cr);
 }
 
-void
-_gtk_pixel_cache_repaint (GtkPixelCache *cache,
-			  GtkPixelCacheDrawFunc draw,
-			  cairo_rectangle_int_t *view_rect,
-			  cairo_rectangle_int_t *canvas_rect,
-			  gpointer user_data)
+/* Repaints the dirty parts of the tiles that are inside view_pos,
+   the parts outside of it stay dirty. The draw function is called
+   once for all of them, so a full repaint costs the same as it would
+   without tiles. With more than one dirty tile, the drawing is
+   recorded and then replayed into each tile, which doesn't need any
+   memory for pixels beyond the tiles. */
+static void
+_gtk_pixel_cache_repaint (GtkPixelCache         *cache,
+                          GtkPixelCacheDrawFunc  draw,
+                          cairo_rectangle_int_t *view_rect,
+                          cairo_rectangle_int_t *canvas_rect,
+                          cairo_rectangle_int_t *view_pos,
+                          gpointer               user_data)
 {
-  cairo_t *backing_cr;
+  cairo_rectangle_int_t area, extents;
+  cairo_rectangle_t record_extents;
+  cairo_region_t *dirty, *paint;
+  cairo_surface_t *recording;
+  cairo_t *cr;
+  GHashTableIter iter;
+  GtkPixelCacheTile *tile;
+  GPtrArray *dirty_tiles, *paint_regions;
+  guint i;
+
+  /* Don't draw outside of the canvas or the view */
+  area.x = 0;
+  area.y = 0;
+  area.width = cache->area_w;
+  area.height = cache->area_h;
+  if (!gdk_rectangle_intersect (&area, view_pos, &area))
+    return;
 
-  if (cache->surface &&
-      cache->surface_dirty &&
-      !cairo_region_is_empty (cache->surface_dirty))
+  dirty = cairo_region_create ();
+  dirty_tiles = g_ptr_array_new ();
+  paint_regions = g_ptr_array_new_with_free_func ((GDestroyNotify) cairo_region_destroy);
+
+  g_hash_table_iter_init (&iter, cache->tiles);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &tile, NULL))
     {
-      backing_cr = cairo_create (cache->surface);
-      gdk_cairo_region (backing_cr, cache->surface_dirty);
-      cairo_clip (backing_cr);
-      cairo_translate (backing_cr,
-		       -cache->surface_x - canvas_rect->x - view_rect->x,
-		       -cache->surface_y - canvas_rect->y - view_rect->y);
-      cairo_set_source_rgba (backing_cr,
-			     0.0, 0, 0, 0.0);
-      cairo_set_operator (backing_cr, CAIRO_OPERATOR_SOURCE);
-      cairo_paint (backing_cr);
-
-      cairo_set_operator (backing_cr, CAIRO_OPERATOR_OVER);
-
-      cairo_save (backing_cr);
-      draw (backing_cr, user_data);
-      cairo_restore (backing_cr);
+      if (tile->dirty == NULL)
+        continue;
+
+      /* In canvas coordinates */
+      paint = cairo_region_copy (tile->dirty);
+      cairo_region_translate (paint, tile->x, tile->y);
+      cairo_region_intersect_rectangle (paint, &area);
+
+      if (cairo_region_is_empty (paint))
+        {
+          cairo_region_destroy (paint);
+          continue;
+        }
+
+      cairo_region_union (dirty, paint);
+      g_ptr_array_add (dirty_tiles, tile);
+      g_ptr_array_add (paint_regions, paint);
+    }
 
-#ifdef G_ENABLE_DEBUG
-      if (gtk_get_debug_flags () & GTK_DEBUG_PIXEL_CACHE)
-	{
-	  GdkRGBA colors[] = {
-	    { 1, 0, 0, 0.08},
-	    { 0, 1, 0, 0.08},
-	    { 0, 0, 1, 0.08},
-	    { 1, 0, 1, 0.08},
-	    { 1, 1, 0, 0.08},
-	    { 0, 1, 1, 0.08},
-	  };
-	  static int current_color = 0;
-
-	  gdk_cairo_set_source_rgba (backing_cr, &colors[(current_color++) % G_N_ELEMENTS (colors)]);
-	  cairo_paint (backing_cr);
-	}
-#endif
+  if (dirty_tiles->len == 1)
+    {
+      /* Draw straight into the tile */
+      tile = g_ptr_array_index (dirty_tiles, 0);
 
-      cairo_destroy (backing_cr);
+      cr = cairo_create (tile->surface);
+      cairo_translate (cr, -tile->x, -tile->y);
+      gdk_cairo_region (cr, dirty);
+      cairo_clip (cr);
+      _gtk_pixel_cache_paint (cr, draw, view_rect, canvas_rect, user_data);
+      cairo_destroy (cr);
+    }
+  else if (dirty_tiles->len > 1)
+    {
+      /* Draw everything once, in canvas coordinates */
+      cairo_region_get_extents (dirty, &extents);
+      record_extents.x = extents.x;
+      record_extents.y = extents.y;
+      record_extents.width = extents.width;
+      record_extents.height = extents.height;
+
+      recording = cairo_recording_surface_create (cache->content, &record_extents);
+      cr = cairo_create (recording);
+      gdk_cairo_region (cr, dirty);
+      cairo_clip (cr);
+      _gtk_pixel_cache_paint (cr, draw, view_rect, canvas_rect, user_data);
+      cairo_destroy (cr);
+
+      for (i = 0; i < dirty_tiles->len; i++)
+        {
+          tile = g_ptr_array_index (dirty_tiles, i);
+
+          cr = cairo_create (tile->surface);
+          cairo_translate (cr, -tile->x, -tile->y);
+          gdk_cairo_region (cr, g_ptr_array_index (paint_regions, i));
+          cairo_clip (cr);
+          cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+          cairo_set_source_surface (cr, recording, 0, 0);
+          cairo_paint (cr);
+          cairo_destroy (cr);
+        }
+
+      cairo_surface_destroy (recording);
     }
 
-  if (cache->surface_dirty)
+  for (i = 0; i < dirty_tiles->len; i++)
     {
-      cairo_region_destroy (cache->surface_dirty);
-      cache->surface_dirty = NULL;
+      tile = g_ptr_array_index (dirty_tiles, i);
+      paint = g_ptr_array_index (paint_regions, i);
+
+      cairo_region_translate (paint, -tile->x, -tile->y);
+      cairo_region_subtract (tile->dirty, paint);
+      if (cairo_region_is_empty (tile->dirty))
+        {
+          cairo_region_destroy (tile->dirty);
+          tile->dirty = NULL;
+        }
     }
+
+  g_ptr_array_free (paint_regions, TRUE);
+  g_ptr_array_free (dirty_tiles, TRUE);
+  cairo_region_destroy (dirty);
 }
 
 static gboolean
@@ -336,14 +523,7 @@ blow_cache_cb  (gpointer user_data)
 
   cache->timeout_tag = 0;
 
-  if (cache->surface)
-    {
-      cairo_surface_destroy (cache->surface);
-      cache->surface = NULL;
-      if (cache->surface_dirty)
-	cairo_region_destroy (cache->surface_dirty);
-      cache->surface_dirty = NULL;
-    }
+  _gtk_pixel_cache_clear (cache);
 
   return G_SOURCE_REMOVE;
 }
@@ -360,28 +540,68 @@ _gtk_pixel_cache_draw (GtkPixelCache *cache,
 		       GtkPixelCacheDrawFunc draw,
 		       gpointer user_data)
 {
+  cairo_rectangle_int_t view_pos;
+  cairo_surface_type_t target_type;
+  GHashTableIter iter;
+  GtkPixelCacheTile *tile;
+  gboolean use_tiles;
+
   if (cache->timeout_tag)
     g_source_remove (cache->timeout_tag);
 
   cache->timeout_tag = g_timeout_add_seconds (BLOW_CACHE_TIMEOUT_SEC,
 					      blow_cache_cb, cache);
 
-  _gtk_pixel_cache_create_surface_if_needed (cache, window,
-					     view_rect, canvas_rect);
-  _gtk_pixel_cache_set_position (cache, view_rect, canvas_rect);
-  _gtk_pixel_cache_repaint (cache, draw, view_rect, canvas_rect, user_data);
+  /* Position of view inside canvas */
+  view_pos.x = -canvas_rect->x;
+  view_pos.y = -canvas_rect->y;
+  view_pos.width = view_rect->width;
+  view_pos.height = view_rect->height;
+
+  /* Don't use tiles if view >= canvas, as we won't
+     be scrolling then anyway */
+  if (view_rect->width >= canvas_rect->width &&
+      view_rect->height >= canvas_rect->height)
+    _gtk_pixel_cache_clear (cache);
+  else
+    _gtk_pixel_cache_update_tiles (cache, window, view_rect, canvas_rect, &view_pos);
+
+  /* Don't use the tiles if rendering elsewhere */
+  use_tiles = FALSE;
+  target_type = cairo_surface_get_type (cairo_get_target (cr));
+  g_hash_table_iter_init (&iter, cache->tiles);
+  if (g_hash_table_iter_next (&iter, (gpointer *) &tile, NULL))
+    use_tiles = cairo_surface_get_type (tile->surface) == target_type;
 
-  if (cache->surface &&
-      /* Don't use backing surface if rendering elsewhere */
-      cairo_surface_get_type (cache->surface) == cairo_surface_get_type (cairo_get_target (cr)))
+  if (use_tiles)
     {
+      _gtk_pixel_cache_repaint (cache, draw,
+                                view_rect, canvas_rect, &view_pos, user_data);
+
       cairo_save (cr);
-      cairo_set_source_surface (cr, cache->surface,
-				cache->surface_x + view_rect->x + canvas_rect->x,
-				cache->surface_y + view_rect->y + canvas_rect->y);
-      cairo_rectangle (cr, view_rect->x, view_rect->y,
-		       view_rect->width, view_rect->height);
-      cairo_fill (cr);
+
+      g_hash_table_iter_init (&iter, cache->tiles);
+      while (g_hash_table_iter_next (&iter, (gpointer *) &tile, NULL))
+        {
+          cairo_rectangle_int_t r;
+
+          r.x = tile->x;
+          r.y = tile->y;
+          r.width = TILE_SIZE;
+          r.height = TILE_SIZE;
+          if (!gdk_rectangle_intersect (&r, &view_pos, &r))
+            continue;
+
+          cairo_set_source_surface (cr, tile->surface,
+                                    tile->x + view_rect->x + canvas_rect->x,
+                                    tile->y + view_rect->y + canvas_rect->y);
+          cairo_rectangle (cr,
+                           r.x + view_rect->x + canvas_rect->x,
+                           r.y + view_rect->y + canvas_rect->y,
+                           r.width, r.height);
+          cairo_fill (cr);
+        }
+
       cairo_restore (cr);
     }
   else
@@ -556,6 +556,90 @@ _gtk_rbtree_insert_before (GtkRBTree *tree,
   return node;
 }
 
+static GtkRBNode *
+gtk_rbtree_fill_helper (GtkRBNode *parent,
+                        guint      n_nodes,
+                        guint      depth,
+                        guint      red_depth,
+                        gint       height,
+                        guint      flags)
+{
+  GtkRBNode *node;
+  guint n_left;
+
+  if (n_nodes == 0)
+    return (GtkRBNode *) &nil;
+
+  n_left = n_nodes / 2;
+
+  node = _gtk_rbnode_new (NULL, height);
+  node->parent = parent;
+  node->flags = (depth == red_depth ? GTK_RBNODE_RED : GTK_RBNODE_BLACK) | flags;
+  node->left = gtk_rbtree_fill_helper (node, n_left, depth + 1, red_depth, height, flags);
+  node->right = gtk_rbtree_fill_helper (node, n_nodes - n_left - 1, depth + 1, red_depth, height, flags);
+  node->count = n_nodes;
+  node->total_count = n_nodes;
+  node->offset = n_nodes * height;
+
+  return node;
+}
+
+/**
+ * _gtk_rbtree_fill:
+ * @tree: an empty tree
+ * @n_nodes: number of nodes to add
+ * @height: height of each node
+ * @valid: whether the nodes are valid
+ *
+ * Fills @tree with @n_nodes nodes at once. This is the same as
+ * calling _gtk_rbtree_insert_after() @n_nodes times, but takes
+ * linear instead of O(n log n) time: the nodes are created as a
+ * balanced tree, so no rebalancing is needed, and the counts and
+ * offsets of parent trees are only updated once.
+ **/
+void
+_gtk_rbtree_fill (GtkRBTree *tree,
+                  guint      n_nodes,
+                  gint       height,
+                  gboolean   valid)
+{
+  guint red_depth;
+
+  g_return_if_fail (_gtk_rbtree_is_nil (tree->root));
+
+  if (n_nodes == 0)
+    return;
+
+  /* Splitting the nodes in half at every level puts all leaves at
+   * two depths at most. If the lowest level isn't full, the nodes
+   * on it are colored red so that all paths have the same number
+   * of black nodes. */
+  if ((n_nodes & (n_nodes + 1)) == 0)
+    red_depth = G_MAXUINT;
+  else
+    red_depth = g_bit_storage (n_nodes + 1) - 1;
+
+  tree->root = gtk_rbtree_fill_helper ((GtkRBNode *) &nil,
+                                       n_nodes,
+                                       0,
+                                       red_depth,
+                                       height,
+                                       valid ? 0 : GTK_RBNODE_INVALID | GTK_RBNODE_DESCENDANTS_INVALID);
+
+  gtk_rbnode_adjust (tree->parent_tree, tree->parent_node,
+                     0, n_nodes, n_nodes * height);
+
+#ifdef G_ENABLE_DEBUG  
+  if (gtk_get_debug_flags () & GTK_DEBUG_TREE)
+    {
+      g_print ("_gtk_rbtree_fill finished...\n");
+      _gtk_rbtree_debug_spew (tree);
+      g_print ("\n\n");
+      _gtk_rbtree_test (G_STRLOC, tree);
+    }
+#endif /* G_ENABLE_DEBUG */
+}
+
 GtkRBNode *
 _gtk_rbtree_find_count (GtkRBTree *tree,
 			gint       count)
@@ -133,6 +133,97 @@ _gtk_widget_has_baseline_support (GtkWidget *widget)
   return widget_class_has_baseline_support (widget_class);
 }
 
+typedef struct {
+  GType type;
+  guint hits;
+  guint misses;
+} SizeRequestStats;
+
+static GHashTable *size_request_stats = NULL;
+static guint size_request_hits = 0;
+static guint size_request_misses = 0;
+
+static gint
+compare_stats_by_misses (gconstpointer a,
+                         gconstpointer b)
+{
+  const SizeRequestStats *stats_a = *(SizeRequestStats * const *) a;
+  const SizeRequestStats *stats_b = *(SizeRequestStats * const *) b;
+
+  if (stats_a->misses != stats_b->misses)
+    return stats_a->misses < stats_b->misses ? 1 : -1;
+
+  return 0;
+}
+
+static void
+size_request_print_stats (void)
+{
+  GHashTableIter iter;
+  GPtrArray *all;
+  gpointer value;
+  guint i;
+
+  g_message ("size requests: %u hits, %u misses (%.1f%% hit rate)",
+             size_request_hits,
+             size_request_misses,
+             100.0 * size_request_hits / (size_request_hits + size_request_misses));
+
+  all = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, size_request_stats);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    g_ptr_array_add (all, value);
+
+  g_ptr_array_sort (all, compare_stats_by_misses);
+
+  for (i = 0; i < MIN (all->len, 10); i++)
+    {
+      SizeRequestStats *stats = g_ptr_array_index (all, i);
+
+      g_message ("  %-24s %u hits, %u misses (%.1f%% hit rate)",
+                 g_type_name (stats->type),
+                 stats->hits,
+                 stats->misses,
+                 100.0 * stats->hits / (stats->hits + stats->misses));
+    }
+
+  g_ptr_array_free (all, TRUE);
+}
+
+static void
+size_request_record_stats (GtkWidget *widget,
+                           gboolean   found_in_cache)
+{
+  SizeRequestStats *stats;
+  GType type;
+
+  if (size_request_stats == NULL)
+    size_request_stats = g_hash_table_new (NULL, NULL);
+
+  type = G_OBJECT_TYPE (widget);
+  stats = g_hash_table_lookup (size_request_stats, GSIZE_TO_POINTER (type));
+  if (stats == NULL)
+    {
+      stats = g_new0 (SizeRequestStats, 1);
+      stats->type = type;
+      g_hash_table_insert (size_request_stats, GSIZE_TO_POINTER (type), stats);
+    }
+
+  if (found_in_cache)
+    {
+      stats->hits++;
+      size_request_hits++;
+    }
+  else
+    {
+      stats->misses++;
+      size_request_misses++;
+    }
+
+  if ((size_request_hits + size_request_misses) % 1000 == 0)
+    size_request_print_stats ();
+}
+
 static void
 gtk_widget_query_size_for_orientation (GtkWidget        *widget,
                                        GtkOrientation    orientation,
@@ -162,6 +253,9 @@ gtk_widget_query_size_for_orientation (GtkWidget        *widget,
 						   &min_baseline,
 						   &nat_baseline);
 
+  if (G_UNLIKELY (gtk_get_debug_flags () & GTK_DEBUG_SIZE_STATS))
+    size_request_record_stats (widget, found_in_cache);
+
   widget_class = GTK_WIDGET_GET_CLASS (widget);
   
   if (!found_in_cache)
@@ -32,34 +32,42 @@ _gtk_size_request_cache_init (SizeRequestCache *cache)
 }
 
 static void
-free_sizes_x (SizeRequestX **sizes)
+free_sizes_x (SizeRequestX **sizes,
+              guint          n_sizes,
+              guint          n_allocated)
 {
-  gint i;
+  guint i;
 
-  for (i = 0; i < GTK_SIZE_REQUEST_CACHED_SIZES && sizes[i] != NULL; i++)
+  for (i = 0; i < n_sizes; i++)
     g_slice_free (SizeRequestX, sizes[i]);
 
-  g_slice_free1 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES, sizes);
+  g_slice_free1 (sizeof (SizeRequestX *) * n_allocated, sizes);
 }
 
 static void
-free_sizes_y (SizeRequestY **sizes)
+free_sizes_y (SizeRequestY **sizes,
+              guint          n_sizes,
+              guint          n_allocated)
 {
-  gint i;
+  guint i;
 
-  for (i = 0; i < GTK_SIZE_REQUEST_CACHED_SIZES && sizes[i] != NULL; i++)
+  for (i = 0; i < n_sizes; i++)
     g_slice_free (SizeRequestY, sizes[i]);
 
-  g_slice_free1 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES, sizes);
+  g_slice_free1 (sizeof (SizeRequestY *) * n_allocated, sizes);
 }
 
 void
 _gtk_size_request_cache_free (SizeRequestCache *cache)
 {
   if (cache->requests_x)
-    free_sizes_x (cache->requests_x);
+    free_sizes_x (cache->requests_x,
+                  cache->flags[GTK_ORIENTATION_HORIZONTAL].n_cached_requests,
+                  cache->flags[GTK_ORIENTATION_HORIZONTAL].n_allocated_requests);
   if (cache->requests_y)
-    free_sizes_y (cache->requests_y);
+    free_sizes_y (cache->requests_y,
+                  cache->flags[GTK_ORIENTATION_VERTICAL].n_cached_requests,
+                  cache->flags[GTK_ORIENTATION_VERTICAL].n_allocated_requests);
 }
 
 void
@@ -69,6 +77,56 @@ _gtk_size_request_cache_clear (SizeRequestCache *cache)
   _gtk_size_request_cache_init (cache);
 }
 
+/* The cached sizes are kept in most recently used order */
+static void
+move_to_front (gpointer *sizes,
+               guint     i)
+{
+  gpointer size = sizes[i];
+
+  memmove (&sizes[1], &sizes[0], i * sizeof (gpointer));
+  sizes[0] = size;
+}
+
+/* Returns the index of the entry to store a new size in */
+static guint
+get_free_slot (SizeRequestCache *cache,
+               GtkOrientation    orientation,
+               gpointer        **sizes,
+               gsize             size_of_entry)
+{
+  guint n_sizes = cache->flags[orientation].n_cached_requests;
+  guint n_allocated = cache->flags[orientation].n_allocated_requests;
+
+  if (n_sizes == n_allocated && n_allocated < GTK_SIZE_REQUEST_MAX_CACHED_SIZES)
+    {
+      gpointer *new_sizes;
+      guint new_allocated;
+
+      new_allocated = MIN (n_allocated + GTK_SIZE_REQUEST_CACHED_SIZES,
+                           GTK_SIZE_REQUEST_MAX_CACHED_SIZES);
+      new_sizes = g_slice_alloc0 (sizeof (gpointer) * new_allocated);
+      if (*sizes)
+        {
+          memcpy (new_sizes, *sizes, sizeof (gpointer) * n_sizes);
+          g_slice_free1 (sizeof (gpointer) * n_allocated, *sizes);
+        }
+
+      *sizes = new_sizes;
+      cache->flags[orientation].n_allocated_requests = new_allocated;
+      n_allocated = new_allocated;
+    }
+
+  /* Replace the least recently used size if there's no room left */
+  if (n_sizes == n_allocated)
+    return n_sizes - 1;
+
+  (*sizes)[n_sizes] = g_slice_alloc (size_of_entry);
+  cache->flags[orientation].n_cached_requests++;
+
+  return n_sizes;
+}
+
 void
 _gtk_size_request_cache_commit (SizeRequestCache *cache,
                                 GtkOrientation    orientation,
@@ -126,31 +184,19 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	    {
 	      cached_sizes[i]->lower_for_size = MIN (cached_sizes[i]->lower_for_size, for_size);
 	      cached_sizes[i]->upper_for_size = MAX (cached_sizes[i]->upper_for_size, for_size);
+	      move_to_front ((gpointer *) cached_sizes, i);
 	      return;
 	    }
 	}
 
-      /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
-
-      if (cache->requests_x == NULL)
-	cache->requests_x = g_slice_alloc0 (sizeof (SizeRequestX *) * GTK_SIZE_REQUEST_CACHED_SIZES);
+      /* If not found, pull a new size from the cache, it will
+       * immediately be used to cache the new computed size */
+      i = get_free_slot (cache, orientation,
+                         (gpointer **) &cache->requests_x, sizeof (SizeRequestX));
 
-      if (cache->requests_x[cache->flags[orientation].last_cached_request] == NULL)
-	cache->requests_x[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestX);
+      cached_size = cache->requests_x[i];
+      move_to_front ((gpointer *) cache->requests_x, i);
 
-      cached_size = cache->requests_x[cache->flags[orientation].last_cached_request];
       cached_size->lower_for_size = for_size;
       cached_size->upper_for_size = for_size;
       cached_size->cached_size.minimum_size = minimum_size;
@@ -171,31 +217,19 @@ _gtk_size_request_cache_commit (SizeRequestCache *cache,
 	    {
 	      cached_sizes[i]->lower_for_size = MIN (cached_sizes[i]->lower_for_size, for_size);
 	      cached_sizes[i]->upper_for_size = MAX (cached_sizes[i]->upper_for_size, for_size);
+	      move_to_front ((gpointer *) cached_sizes, i);
 	      return;
 	    }
 	}
 
-      /* If not found, pull a new size from the cache, the returned size cache
-       * will immediately be used to cache the new computed size so we go ahead
-       * and increment the last_cached_request right away */
-      if (n_sizes < GTK_SIZE_REQUEST_CACHED_SIZES)
-	{
-	  cache->flags[orientation].n_cached_requests++;
-	  cache->flags[orientation].last_cached_request = cache->flags[orientation].n_cached_requests - 1;
-	}
-      else
-	{
-	  if (++cache->flags[orientation].last_cached_request == GTK_SIZE_REQUEST_CACHED_SIZES)
-	    cache->flags[orientation].last_cached_request = 0;
-	}
-
-      if (cache->requests_y == NULL)
-	cache->requests_y = g_slice_alloc0 (sizeof (SizeRequestY *) * GTK_SIZE_REQUEST_CACHED_SIZES);
+      /* If not found, pull a new size from the cache, it will
+       * immediately be used to cache the new computed size */
+      i = get_free_slot (cache, orientation,
+                         (gpointer **) &cache->requests_y, sizeof (SizeRequestY));
 
-      if (cache->requests_y[cache->flags[orientation].last_cached_request] == NULL)
-	cache->requests_y[cache->flags[orientation].last_cached_request] = g_slice_new (SizeRequestY);
+      cached_size = cache->requests_y[i];
+      move_to_front ((gpointer *) cache->requests_y, i);
 
-      cached_size = cache->requests_y[cache->flags[orientation].last_cached_request];
       cached_size->lower_for_size = for_size;
       cached_size->upper_for_size = for_size;
       cached_size->cached_size.minimum_size = minimum_size;
@@ -241,6 +275,7 @@ _gtk_size_request_cache_lookup (SizeRequestCache *cache,
 		  cur->upper_for_size >= for_size)
 		{
 		  result = &cur->cached_size;
+		  move_to_front ((gpointer *) cache->requests_x, i);
 		  break;
 		}
 	    }
@@ -279,6 +314,7 @@ _gtk_size_request_cache_lookup (SizeRequestCache *cache,
 		  cur->upper_for_size >= for_size)
 		{
 		  result = &cur->cached_size;
+		  move_to_front ((gpointer *) cache->requests_y, i);
 		  break;
 		}
 	    }
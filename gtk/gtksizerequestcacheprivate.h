@@ -35,8 +35,16 @@ G_BEGIN_DECLS
  * for a said widget to have, if a label can
  * only wrap to 3 lines, only 3 caches will
  * ever be allocated for it.
+ *
+ * Room for GTK_SIZE_REQUEST_CACHED_SIZES ranges
+ * is allocated at a time. When a widget keeps
+ * being asked for more sizes than fit, the cache
+ * grows up to GTK_SIZE_REQUEST_MAX_CACHED_SIZES,
+ * after that the least recently used range is
+ * replaced.
  */
-#define GTK_SIZE_REQUEST_CACHED_SIZES   (5)
+#define GTK_SIZE_REQUEST_CACHED_SIZES     (5)
+#define GTK_SIZE_REQUEST_MAX_CACHED_SIZES (20)
 
 typedef struct {
   gint minimum_size;
@@ -74,8 +82,8 @@ typedef struct {
   GtkSizeRequestMode request_mode   : 3;
   guint       request_mode_valid    : 1;
   struct {
-    guint       n_cached_requests   : 3;
-    guint       last_cached_request : 3;
+    guint       n_cached_requests   : 5;
+    guint       n_allocated_requests : 5;
     guint       cached_size_valid   : 1;
   }           flags[2];
 } SizeRequestCache;
@@ -19,11 +19,15 @@
 
 #include "gtkstylecascadeprivate.h"
 
+#include "gtkcsscomputedvaluesprivate.h"
+#include "gtkcssselectorprivate.h"
 #include "gtkstyleprovider.h"
 #include "gtkstyleproviderprivate.h"
+#include "gtkwidgetpathprivate.h"
 
 typedef struct _GtkStyleCascadeIter GtkStyleCascadeIter;
 typedef struct _GtkStyleProviderData GtkStyleProviderData;
+typedef struct _GtkStyleCacheKey GtkStyleCacheKey;
 
 struct _GtkStyleCascadeIter {
   int parent_index; /* pointing at last index that was returned, not next one that should be returned */
@@ -37,6 +41,22 @@ struct _GtkStyleProviderData
   guint changed_signal_id;
 };
 
+/* The style cache allows style contexts to share computed values.
+ * Two contexts with equal widget paths, states and parent values will
+ * always compute the same values, so the first context that computes
+ * them publishes them here and all others reuse them.
+ * Values published in the cache must never be modified again. The
+ * cache does not keep them alive, entries are dropped as soon as the
+ * last style context stops using them.
+ */
+struct _GtkStyleCacheKey
+{
+  GtkStyleCascade      *cascade;
+  GtkWidgetPath        *path;
+  GtkStateFlags         state;
+  GtkCssComputedValues *parent_values;
+};
+
 static GtkStyleProvider *
 gtk_style_cascade_iter_next (GtkStyleCascade     *cascade,
                              GtkStyleCascadeIter *iter)
@@ -252,6 +272,75 @@ gtk_style_cascade_get_change (GtkStyleProviderPrivate *provider,
   return change;
 }
 
+static guint
+style_cache_key_hash (gconstpointer data)
+{
+  const GtkStyleCacheKey *key = data;
+
+  return _gtk_widget_path_hash (key->path)
+         ^ (key->state << 16)
+         ^ g_direct_hash (key->parent_values);
+}
+
+static gboolean
+style_cache_key_equal (gconstpointer data1,
+                       gconstpointer data2)
+{
+  const GtkStyleCacheKey *key1 = data1;
+  const GtkStyleCacheKey *key2 = data2;
+
+  return key1->state == key2->state &&
+         key1->parent_values == key2->parent_values &&
+         _gtk_widget_path_equal (key1->path, key2->path);
+}
+
+static void
+style_cache_key_free (gpointer data)
+{
+  GtkStyleCacheKey *key = data;
+
+  gtk_widget_path_unref (key->path);
+  if (key->parent_values)
+    g_object_unref (key->parent_values);
+
+  g_slice_free (GtkStyleCacheKey, key);
+}
+
+static void
+style_cache_values_finalized (gpointer  data,
+                              GObject  *where_the_object_was)
+{
+  GtkStyleCacheKey *key = data;
+
+  g_hash_table_steal (key->cascade->style_cache, key);
+  style_cache_key_free (key);
+}
+
+static void
+gtk_style_cascade_clear_style_cache (GtkStyleCascade *cascade)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_hash_table_iter_init (&iter, cascade->style_cache);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_object_weak_unref (value, style_cache_values_finalized, key);
+
+  g_hash_table_remove_all (cascade->style_cache);
+}
+
+/* The cache must be cleared before the signal is emitted, style
+ * contexts connected to it may look up values right away. So all
+ * changes go through here instead of a class handler for the signal.
+ */
+static void
+gtk_style_cascade_changed (GtkStyleCascade *cascade)
+{
+  gtk_style_cascade_clear_style_cache (cascade);
+
+  _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (cascade));
+}
+
 static void
 gtk_style_cascade_provider_private_iface_init (GtkStyleProviderPrivateInterface *iface)
 {
@@ -275,6 +364,12 @@ gtk_style_cascade_dispose (GObject *object)
 
   _gtk_style_cascade_set_parent (cascade, NULL);
   g_array_unref (cascade->providers);
+  if (cascade->style_cache)
+    {
+      gtk_style_cascade_clear_style_cache (cascade);
+      g_hash_table_unref (cascade->style_cache);
+      cascade->style_cache = NULL;
+    }
 
   G_OBJECT_CLASS (_gtk_style_cascade_parent_class)->dispose (object);
 }
@@ -301,6 +396,11 @@ _gtk_style_cascade_init (GtkStyleCascade *cascade)
 {
   cascade->providers = g_array_new (FALSE, FALSE, sizeof (GtkStyleProviderData));
   g_array_set_clear_func (cascade->providers, style_provider_data_clear);
+
+  cascade->style_cache = g_hash_table_new_full (style_cache_key_hash,
+                                                style_cache_key_equal,
+                                                style_cache_key_free,
+                                                NULL);
 }
 
 GtkStyleCascade *
@@ -347,19 +447,22 @@ _gtk_style_cascade_set_parent (GtkStyleCascade *cascade,
       g_object_ref (parent);
       g_signal_connect_swapped (parent,
                                 "-gtk-private-changed",
-                                G_CALLBACK (_gtk_style_provider_private_changed),
+                                G_CALLBACK (gtk_style_cascade_changed),
                                 cascade);
     }
 
   if (cascade->parent)
     {
       g_signal_handlers_disconnect_by_func (cascade->parent, 
-                                            _gtk_style_provider_private_changed,
+                                            gtk_style_cascade_changed,
                                             cascade);
       g_object_unref (cascade->parent);
     }
 
   cascade->parent = parent;
+
+  /* Cached styles were looked up in the old parent */
+  gtk_style_cascade_clear_style_cache (cascade);
 }
 
 void
@@ -378,7 +481,7 @@ _gtk_style_cascade_add_provider (GtkStyleCascade  *cascade,
   data.priority = priority;
   data.changed_signal_id = g_signal_connect_swapped (provider,
                                                      "-gtk-private-changed",
-                                                     G_CALLBACK (_gtk_style_provider_private_changed),
+                                                     G_CALLBACK (gtk_style_cascade_changed),
                                                      cascade);
 
   /* ensure it gets removed first */
@@ -391,7 +494,7 @@ _gtk_style_cascade_add_provider (GtkStyleCascade  *cascade,
     }
   g_array_insert_val (cascade->providers, i, data);
 
-  _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (cascade));
+  gtk_style_cascade_changed (cascade);
 }
 
 void
@@ -411,9 +514,138 @@ _gtk_style_cascade_remove_provider (GtkStyleCascade  *cascade,
         {
           g_array_remove_index (cascade->providers, i);
   
-          _gtk_style_provider_private_changed (GTK_STYLE_PROVIDER_PRIVATE (cascade));
+          gtk_style_cascade_changed (cascade);
           break;
         }
     }
 }
 
+
+/**
+ * _gtk_style_cascade_lookup_values:
+ * @cascade: the cascade
+ * @path: the widget path to look up values for
+ * @state: the state to look up values for
+ * @parent_values: (allow-none): the values of the parent or %NULL for
+ *     toplevels. These must be shared values themselves.
+ *
+ * Looks up values previously added with _gtk_style_cascade_add_values()
+ * for the given arguments.
+ *
+ * Returns: (transfer full): the shared values or %NULL if none were found.
+ *     The returned values must not be modified.
+ **/
+GtkCssComputedValues *
+_gtk_style_cascade_lookup_values (GtkStyleCascade      *cascade,
+                                  const GtkWidgetPath  *path,
+                                  GtkStateFlags         state,
+                                  GtkCssComputedValues *parent_values)
+{
+  GtkStyleCacheKey key;
+  GtkCssComputedValues *values;
+
+  g_return_val_if_fail (GTK_IS_STYLE_CASCADE (cascade), NULL);
+  g_return_val_if_fail (path != NULL, NULL);
+
+  key.cascade = cascade;
+  key.path = (GtkWidgetPath *) path;
+  key.state = state;
+  key.parent_values = parent_values;
+
+  values = g_hash_table_lookup (cascade->style_cache, &key);
+  if (values == NULL)
+    {
+      cascade->style_cache_misses++;
+      return NULL;
+    }
+
+  cascade->style_cache_hits++;
+
+  return g_object_ref (values);
+}
+
+/**
+ * _gtk_style_cascade_add_values:
+ * @cascade: the cascade
+ * @path: the widget path the values were computed for
+ * @state: the state the values were computed for
+ * @parent_values: (allow-none): the parent values used for computing
+ * @values: the computed values
+ *
+ * Makes @values available to other style contexts. From now on,
+ * @values must not be modified anymore. The cache does not keep a
+ * reference to @values, they are removed from the cache when they
+ * get finalized.
+ **/
+void
+_gtk_style_cascade_add_values (GtkStyleCascade      *cascade,
+                               GtkWidgetPath        *path,
+                               GtkStateFlags         state,
+                               GtkCssComputedValues *parent_values,
+                               GtkCssComputedValues *values)
+{
+  GtkStyleCacheKey *key;
+
+  g_return_if_fail (GTK_IS_STYLE_CASCADE (cascade));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (GTK_IS_CSS_COMPUTED_VALUES (values));
+
+  key = g_slice_new (GtkStyleCacheKey);
+  key->cascade = cascade;
+  key->path = gtk_widget_path_ref (path);
+  key->state = state;
+  key->parent_values = parent_values ? g_object_ref (parent_values) : NULL;
+
+  if (g_hash_table_contains (cascade->style_cache, key))
+    {
+      style_cache_key_free (key);
+      return;
+    }
+
+  g_object_weak_ref (G_OBJECT (values), style_cache_values_finalized, key);
+  g_hash_table_insert (cascade->style_cache, key, values);
+}
+
+void
+_gtk_style_cascade_get_cache_stats (GtkStyleCascade *cascade,
+                                    guint           *n_entries,
+                                    guint           *hits,
+                                    guint           *misses)
+{
+  g_return_if_fail (GTK_IS_STYLE_CASCADE (cascade));
+
+  if (n_entries)
+    *n_entries = g_hash_table_size (cascade->style_cache);
+  if (hits)
+    *hits = cascade->style_cache_hits;
+  if (misses)
+    *misses = cascade->style_cache_misses;
+}
+
+void
+_gtk_style_cascade_print_stats (GtkStyleCascade *cascade)
+{
+  guint total, rejected, walked;
+
+  g_return_if_fail (GTK_IS_STYLE_CASCADE (cascade));
+
+  total = cascade->style_cache_hits + cascade->style_cache_misses;
+  if (total == cascade->style_cache_reported)
+    return;
+
+  cascade->style_cache_reported = total;
+
+  g_message ("style cascade %p: %u shared styles, %u hits, %u misses (%.1f%% hit rate)",
+             cascade,
+             g_hash_table_size (cascade->style_cache),
+             cascade->style_cache_hits,
+             cascade->style_cache_misses,
+             100.0 * cascade->style_cache_hits / total);
+
+  _gtk_css_selector_tree_get_stats (&rejected, &walked);
+  if (rejected + walked > 0)
+    g_message ("selector tree: %u parent walks, %u avoided by the ancestor filter (%.1f%%)",
+               walked,
+               rejected,
+               100.0 * rejected / (rejected + walked));
+}
@@ -19,6 +19,7 @@
 #define __GTK_STYLECASCADE_PRIVATE_H__
 
 #include <gdk/gdk.h>
+#include <gtk/gtkcsstypesprivate.h>
 #include <gtk/gtkstyleproviderprivate.h>
 
 G_BEGIN_DECLS
@@ -39,6 +40,11 @@ struct _GtkStyleCascade
 
   GtkStyleCascade *parent;
   GArray *providers;
+
+  GHashTable *style_cache;      /* GtkStyleCacheKey => GtkCssComputedValues (weak) */
+  guint style_cache_hits;
+  guint style_cache_misses;
+  guint style_cache_reported;   /* hits + misses at the last _gtk_style_cascade_print_stats() */
 };
 
 struct _GtkStyleCascadeClass
@@ -60,6 +66,21 @@ void                  _gtk_style_cascade_add_provider           (GtkStyleCascade
 void                  _gtk_style_cascade_remove_provider        (GtkStyleCascade     *cascade,
                                                                  GtkStyleProvider    *provider);
 
+GtkCssComputedValues *_gtk_style_cascade_lookup_values          (GtkStyleCascade     *cascade,
+                                                                 const GtkWidgetPath *path,
+                                                                 GtkStateFlags        state,
+                                                                 GtkCssComputedValues *parent_values);
+void                  _gtk_style_cascade_add_values             (GtkStyleCascade     *cascade,
+                                                                 GtkWidgetPath       *path,
+                                                                 GtkStateFlags        state,
+                                                                 GtkCssComputedValues *parent_values,
+                                                                 GtkCssComputedValues *values);
+void                  _gtk_style_cascade_get_cache_stats        (GtkStyleCascade     *cascade,
+                                                                 guint               *n_entries,
+                                                                 guint               *hits,
+                                                                 guint               *misses);
+void                  _gtk_style_cascade_print_stats            (GtkStyleCascade     *cascade);
+
 
 G_END_DECLS
 
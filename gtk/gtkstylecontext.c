@@ -27,6 +27,7 @@
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkcsscornervalueprivate.h"
 #include "gtkcssenginevalueprivate.h"
+#include "gtkcsscomputedvaluesprivate.h"
 #include "gtkcssnumbervalueprivate.h"
 #include "gtkcssrgbavalueprivate.h"
 #include "gtkdebug.h"
@@ -350,6 +351,7 @@ struct StyleData
   GtkCssComputedValues *store;
   GArray *property_cache;
   guint ref_count;
+  guint shared : 1;     /* store is in the cascade's style cache and must not be modified */
 };
 
 struct _GtkStyleContextPrivate
@@ -977,20 +979,20 @@ create_query_path (GtkStyleContext *context,
 static void
 build_properties (GtkStyleContext      *context,
                   GtkCssComputedValues *values,
-                  GtkStyleInfo         *info,
+                  const GtkWidgetPath  *path,
+                  GtkStateFlags         state,
+                  GtkCssComputedValues *parent_values,
                   const GtkBitmask     *relevant_changes)
 {
   GtkStyleContextPrivate *priv;
   GtkCssMatcher matcher;
-  GtkWidgetPath *path;
   GtkCssLookup *lookup;
 
   priv = context->priv;
 
-  path = create_query_path (context, info);
   lookup = _gtk_css_lookup_new (relevant_changes);
 
-  if (_gtk_css_matcher_init (&matcher, path, info->state_flags))
+  if (_gtk_css_matcher_init (&matcher, path, state))
     _gtk_style_provider_private_lookup (GTK_STYLE_PROVIDER_PRIVATE (priv->cascade),
                                         &matcher,
                                         lookup);
@@ -998,10 +1000,71 @@ build_properties (GtkStyleContext      *context,
   _gtk_css_lookup_resolve (lookup, 
                            GTK_STYLE_PROVIDER_PRIVATE (priv->cascade),
                            values,
-                           priv->parent ? style_data_lookup (priv->parent)->store : NULL);
+                           parent_values);
 
   _gtk_css_lookup_free (lookup);
-  gtk_widget_path_free (path);
+}
+
+/* Sets the store of @data to the values for @info. If possible, the
+ * values are shared with other style contexts via the cascade's style
+ * cache. This is only possible if the parent's values are shared, too,
+ * as the cache uses them as part of the key.
+ */
+static void
+style_data_build (GtkStyleContext *context,
+                  StyleData       *data,
+                  GtkStyleInfo    *info)
+{
+  GtkStyleContextPrivate *priv;
+  GtkCssComputedValues *values, *parent_values;
+  StyleData *parent_data;
+  GtkWidgetPath *path;
+
+  priv = context->priv;
+
+  parent_data = priv->parent ? style_data_lookup (priv->parent) : NULL;
+  parent_values = parent_data ? parent_data->store : NULL;
+  path = create_query_path (context, info);
+
+  if ((parent_data == NULL || parent_data->shared) &&
+      G_LIKELY (!(gtk_get_debug_flags () & GTK_DEBUG_NO_CSS_CACHE)))
+    {
+      values = _gtk_style_cascade_lookup_values (priv->cascade, path, info->state_flags, parent_values);
+      if (values == NULL)
+        {
+          values = _gtk_css_computed_values_new ();
+          build_properties (context, values, path, info->state_flags, parent_values, NULL);
+          _gtk_style_cascade_add_values (priv->cascade, path, info->state_flags, parent_values, values);
+        }
+      data->shared = TRUE;
+    }
+  else
+    {
+      values = _gtk_css_computed_values_new ();
+      build_properties (context, values, path, info->state_flags, parent_values, NULL);
+      data->shared = FALSE;
+    }
+
+  if (data->store)
+    g_object_unref (data->store);
+  data->store = values;
+
+  gtk_widget_path_unref (path);
+}
+
+/* Makes sure the store of @data can be modified. */
+static void
+style_data_unshare (StyleData *data)
+{
+  GtkCssComputedValues *copy;
+
+  if (!data->shared)
+    return;
+
+  copy = _gtk_css_computed_values_copy (data->store);
+  g_object_unref (data->store);
+  data->store = copy;
+  data->shared = FALSE;
 }
 
 static StyleData *
@@ -1028,13 +1091,12 @@ style_data_lookup (GtkStyleContext *context)
     }
 
   data = style_data_new ();
-  data->store = _gtk_css_computed_values_new ();
   style_info_set_data (info, data);
   g_hash_table_insert (priv->style_data,
                        style_info_copy (info),
                        data);
 
-  build_properties (context, data->store, info, NULL);
+  style_data_build (context, data, info);
 
   return data;
 }
@@ -3069,8 +3131,28 @@ gtk_style_context_update_cache (GtkStyleContext  *context,
 
       changes = _gtk_css_computed_values_compute_dependencies (data->store, parent_changes);
 
-      if (!_gtk_bitmask_is_empty (changes))
-	build_properties (context, data->store, info, changes);
+      if (_gtk_bitmask_is_empty (changes))
+        {
+          /* nothing to do */
+        }
+      else if (data->shared)
+        {
+          /* parent values changed, so we need to look up by the new ones */
+          style_data_build (context, data, info);
+        }
+      else
+        {
+          GtkWidgetPath *path = create_query_path (context, info);
+
+          build_properties (context,
+                            data->store,
+                            path,
+                            info->state_flags,
+                            priv->parent ? style_data_lookup (priv->parent)->store : NULL,
+                            changes);
+
+          gtk_widget_path_unref (path);
+        }
 
       _gtk_bitmask_free (changes);
     }
@@ -3106,6 +3188,13 @@ gtk_style_context_update_animations (GtkStyleContext *context,
   
   style_data = style_data_lookup (context);
 
+  /* shared values never have animations */
+  if (style_data->shared)
+    {
+      _gtk_style_context_update_animating (context);
+      return _gtk_bitmask_new ();
+    }
+
   differences = _gtk_css_computed_values_advance (style_data->store,
                                                   timestamp);
 
@@ -3239,6 +3328,9 @@ _gtk_style_context_validate (GtkStyleContext  *context,
 
       data = style_data_lookup (context);
 
+      if (data->shared && _gtk_css_computed_values_is_animatable (data->store))
+        style_data_unshare (data);
+
       _gtk_css_computed_values_create_animations (data->store,
                                                   priv->parent ? style_data_lookup (priv->parent)->store : NULL,
                                                   timestamp,
@@ -3304,6 +3396,10 @@ _gtk_style_context_validate (GtkStyleContext  *context,
     }
 
   _gtk_bitmask_free (changes);
+
+  if (G_UNLIKELY (gtk_get_debug_flags () & GTK_DEBUG_CSS_STATS) &&
+      priv->parent == NULL)
+    _gtk_style_cascade_print_stats (priv->cascade);
 }
 
 void
@@ -846,6 +846,9 @@ gtk_text_layout_draw (GtkTextLayout *layout,
   if (line_list == NULL)
     return; /* nothing on the screen */
 
+  /* Keep the displays of all visible lines around for the next draw */
+  _gtk_text_layout_set_line_display_cache_size (layout, g_slist_length (line_list));
+
   text_renderer = get_text_renderer ();
   text_renderer_begin (text_renderer, widget, cr);
 
@@ -4501,6 +4501,86 @@ exact_prefix_cmp (const gchar *string,
          type != G_UNICODE_NON_SPACING_MARK;
 }
 
+static gboolean
+is_ascii (const gchar *str,
+          gssize       len)
+{
+  const guchar *p = (const guchar *) str;
+
+  if (len < 0)
+    {
+      for (; *p; p++)
+        if (*p >= 0x80)
+          return FALSE;
+    }
+  else
+    {
+      const guchar *end = p + len;
+
+      for (; p < end; p++)
+        if (*p >= 0x80)
+          return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Casefolding and normalization don't change ASCII text other
+ * than mapping upper to lower case, so when both strings are
+ * ASCII we can compare them directly without allocating.
+ * @needle is casefolded already.
+ */
+static const gchar *
+ascii_strcasestr (const gchar *haystack,
+                  const gchar *needle)
+{
+  gsize needle_len;
+  gchar accept[3];
+  const gchar *p;
+
+  needle_len = strlen (needle);
+  if (needle_len == 0)
+    return haystack;
+
+  accept[0] = needle[0];
+  accept[1] = g_ascii_toupper (needle[0]);
+  accept[2] = '\0';
+
+  for (p = strpbrk (haystack, accept); p != NULL; p = strpbrk (p + 1, accept))
+    {
+      if (g_ascii_strncasecmp (p, needle, needle_len) == 0)
+        return p;
+    }
+
+  return NULL;
+}
+
+static const gchar *
+ascii_strrcasestr (const gchar *haystack,
+                   const gchar *needle)
+{
+  gsize needle_len;
+  gsize haystack_len;
+  const gchar *p;
+
+  needle_len = strlen (needle);
+  if (needle_len == 0)
+    return haystack;
+
+  haystack_len = strlen (haystack);
+  if (haystack_len < needle_len)
+    return NULL;
+
+  for (p = haystack + haystack_len - needle_len; p >= haystack; p--)
+    {
+      if (g_ascii_tolower (*p) == needle[0] &&
+          g_ascii_strncasecmp (p, needle, needle_len) == 0)
+        return p;
+    }
+
+  return NULL;
+}
+
 static const gchar *
 utf8_strcasestr (const gchar *haystack,
                  const gchar *needle)
@@ -4516,6 +4596,9 @@ utf8_strcasestr (const gchar *haystack,
   g_return_val_if_fail (haystack != NULL, NULL);
   g_return_val_if_fail (needle != NULL, NULL);
 
+  if (is_ascii (needle, -1) && is_ascii (haystack, -1))
+    return ascii_strcasestr (haystack, needle);
+
   casefold = g_utf8_casefold (haystack, -1);
   caseless_haystack = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
   g_free (casefold);
@@ -4572,6 +4655,9 @@ utf8_strrcasestr (const gchar *haystack,
   g_return_val_if_fail (haystack != NULL, NULL);
   g_return_val_if_fail (needle != NULL, NULL);
 
+  if (is_ascii (needle, -1) && is_ascii (haystack, -1))
+    return ascii_strrcasestr (haystack, needle);
+
   casefold = g_utf8_casefold (haystack, -1);
   caseless_haystack = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
   g_free (casefold);
@@ -4633,6 +4719,9 @@ utf8_caselessnmatch (const gchar *s1,
   g_return_val_if_fail (n1 > 0, FALSE);
   g_return_val_if_fail (n2 > 0, FALSE);
 
+  if (is_ascii (s1, n1) && is_ascii (s2, n2))
+    return n1 >= n2 && g_ascii_strncasecmp (s1, s2, n2) == 0;
+
   casefold = g_utf8_casefold (s1, n1);
   normalized_s1 = g_utf8_normalize (casefold, -1, G_NORMALIZE_NFD);
   g_free (casefold);
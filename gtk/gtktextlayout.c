@@ -83,6 +83,7 @@
 #include "gtktextiterprivate.h"
 #include "gtktextutil.h"
 #include "gtkintl.h"
+#include "gtkdebug.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -97,8 +98,24 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* Recently used line displays, most recent first. The links
+     are stored in line_display_cache by line. Only lines that
+     have line data for the layout are kept here, as that is how
+     we learn that a line goes away. */
+  GQueue line_display_lru;
+  GHashTable *line_display_cache;
+  guint line_display_cache_size;
+
+  guint line_display_hits;
+  guint line_display_misses;
 };
 
+/* Number of line displays that are kept around in
+ * addition to the ones needed to draw the visible lines
+ */
+#define LINE_DISPLAY_CACHE_MARGIN 16
+
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
                                                    GtkTextLine *line,
                                                    /* may be NULL */
@@ -127,6 +144,8 @@ static void gtk_text_layout_emit_changed           (GtkTextLayout     *layout,
 
 static void gtk_text_layout_invalidate_all (GtkTextLayout *layout);
 
+static void line_display_cache_clear (GtkTextLayout *layout);
+
 static PangoAttribute *gtk_text_attr_appearance_new (const GtkTextAppearance *appearance);
 
 static void gtk_text_layout_mark_set_handler    (GtkTextBuffer     *buffer,
@@ -193,12 +212,7 @@ gtk_text_layout_dispose (GObject *object)
   g_clear_object (&layout->ltr_context);
   g_clear_object (&layout->rtl_context);
 
-  if (layout->one_display_cache)
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  line_display_cache_clear (layout);
 
   if (layout->preedit_attrs != NULL)
     {
@@ -213,11 +227,15 @@ static void
 gtk_text_layout_finalize (GObject *object)
 {
   GtkTextLayout *layout;
+  GtkTextLayoutPrivate *priv;
 
   layout = GTK_TEXT_LAYOUT (object);
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
 
   g_free (layout->preedit_string);
 
+  g_hash_table_destroy (priv->line_display_cache);
+
   G_OBJECT_CLASS (gtk_text_layout_parent_class)->finalize (object);
 }
 
@@ -278,7 +296,13 @@ gtk_text_layout_class_init (GtkTextLayoutClass *klass)
 static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+
   text_layout->cursor_visible = TRUE;
+
+  g_queue_init (&priv->line_display_lru);
+  priv->line_display_cache = g_hash_table_new (NULL, NULL);
+  priv->line_display_cache_size = LINE_DISPLAY_CACHE_MARGIN;
 }
 
 GtkTextLayout*
@@ -312,6 +336,7 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  line_display_cache_clear (layout);
 
   if (layout->buffer)
     {
@@ -630,6 +655,18 @@ gtk_text_layout_emit_changed (GtkTextLayout *layout,
   g_signal_emit (layout, signals[CHANGED], 0, y, old_height, new_height);
 }
 
+static gboolean
+line_display_intersects (GtkTextLayout      *layout,
+                         GtkTextLineDisplay *display,
+                         gint                y,
+                         gint                height)
+{
+  gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
+                                                display->line, layout);
+
+  return cache_y + display->height > y && cache_y < y + height;
+}
+
 static void
 text_layout_changed (GtkTextLayout *layout,
                      gint           y,
@@ -637,20 +674,26 @@ text_layout_changed (GtkTextLayout *layout,
                      gint           new_height,
                      gboolean       cursors_only)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *l, *next;
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
-  if (layout->one_display_cache)
+  for (l = priv->line_display_lru.head; l != NULL; l = next)
     {
-      GtkTextLine *line = layout->one_display_cache->line;
-      gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
-						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+      GtkTextLineDisplay *display = l->data;
+
+      next = l->next;
 
-      if (cache_y + cache_height > y && cache_y < y + old_height)
-	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
+      if (line_display_intersects (layout, display, y, old_height))
+	gtk_text_layout_invalidate_cache (layout, display->line, cursors_only);
     }
 
+  if (layout->one_display_cache &&
+      line_display_intersects (layout, layout->one_display_cache, y, old_height))
+    gtk_text_layout_invalidate_cache (layout, layout->one_display_cache->line, cursors_only);
+
   gtk_text_layout_emit_changed (layout, y, old_height, new_height);
 }
 
@@ -815,15 +858,164 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   gtk_text_layout_invalidate (layout, &start, &end);
 }
 
+static void
+line_display_free (GtkTextLineDisplay *display)
+{
+  if (display->layout)
+    g_object_unref (display->layout);
+
+  if (display->cursors)
+    g_array_free (display->cursors, TRUE);
+
+  if (display->pg_bg_color)
+    gdk_color_free (display->pg_bg_color);
+
+  if (display->pg_bg_rgba)
+    gdk_rgba_free (display->pg_bg_rgba);
+
+  g_slice_free (GtkTextLineDisplay, display);
+}
+
+static GtkTextLineDisplay *
+line_display_cache_lookup (GtkTextLayout *layout,
+                           GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->line_display_cache, line);
+  if (link)
+    return link->data;
+
+  if (layout->one_display_cache && layout->one_display_cache->line == line)
+    return layout->one_display_cache;
+
+  return NULL;
+}
+
+static gboolean
+line_display_is_cached (GtkTextLayout      *layout,
+                        GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  if (display == layout->one_display_cache)
+    return TRUE;
+
+  link = g_hash_table_lookup (priv->line_display_cache, display->line);
+
+  return link != NULL && link->data == display;
+}
+
+static void
+line_display_cache_remove (GtkTextLayout      *layout,
+                           GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  if (display == layout->one_display_cache)
+    {
+      layout->one_display_cache = NULL;
+    }
+  else
+    {
+      link = g_hash_table_lookup (priv->line_display_cache, display->line);
+      g_assert (link != NULL && link->data == display);
+
+      g_hash_table_remove (priv->line_display_cache, display->line);
+      g_queue_delete_link (&priv->line_display_lru, link);
+    }
+
+  line_display_free (display);
+}
+
+static void
+line_display_cache_trim (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->line_display_lru.length > priv->line_display_cache_size)
+    line_display_cache_remove (layout, priv->line_display_lru.tail->data);
+}
+
+/* Makes @display the most recently used display */
+static void
+line_display_cache_insert (GtkTextLayout      *layout,
+                           GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->line_display_cache, display->line);
+  if (link)
+    {
+      g_assert (link->data == display);
+      g_queue_unlink (&priv->line_display_lru, link);
+      g_queue_push_head_link (&priv->line_display_lru, link);
+      return;
+    }
+
+  if (display == layout->one_display_cache)
+    layout->one_display_cache = NULL;
+
+  /* We only get to know that a line is deleted when it has
+   * line data for us, other lines only get the single slot
+   * that is replaced by the next such line.
+   */
+  if (_gtk_text_line_get_data (display->line, layout) == NULL)
+    {
+      if (layout->one_display_cache)
+        line_display_free (layout->one_display_cache);
+      layout->one_display_cache = display;
+      return;
+    }
+
+  g_queue_push_head (&priv->line_display_lru, display);
+  g_hash_table_insert (priv->line_display_cache,
+                       display->line, priv->line_display_lru.head);
+
+  line_display_cache_trim (layout);
+}
+
+static void
+line_display_cache_clear (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->line_display_lru.head)
+    line_display_cache_remove (layout, priv->line_display_lru.head->data);
+
+  if (layout->one_display_cache)
+    line_display_cache_remove (layout, layout->one_display_cache);
+}
+
+/* Keeps enough line displays around to draw @n_lines lines
+ * without building any of them twice. The cache never shrinks,
+ * small redraws like a cursor blink shouldn't drop the displays
+ * of the other visible lines.
+ */
+void
+_gtk_text_layout_set_line_display_cache_size (GtkTextLayout *layout,
+                                              guint          n_lines)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  priv->line_display_cache_size = MAX (priv->line_display_cache_size,
+                                       n_lines + LINE_DISPLAY_CACHE_MARGIN);
+}
+
 static void
 gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
-  if (layout->one_display_cache && line == layout->one_display_cache->line)
-    {
-      GtkTextLineDisplay *display = layout->one_display_cache;
+  GtkTextLineDisplay *display;
 
+  display = line_display_cache_lookup (layout, line);
+  if (display)
+    {
       if (cursors_only)
 	{
           if (display->cursors)
@@ -834,8 +1026,7 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
 	}
       else
 	{
-	  layout->one_display_cache = NULL;
-	  gtk_text_layout_free_line_display (layout, display);
+	  line_display_cache_remove (layout, display);
 	}
     }
 }
@@ -923,39 +1114,54 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
   gtk_text_layout_invalidated (layout);
 }
 
+static gboolean
+line_display_in_range (GtkTextLayout      *layout,
+                       GtkTextLineDisplay *display,
+                       const GtkTextIter  *start,
+                       const GtkTextIter  *end)
+{
+  GtkTextIter line_start, line_end;
+
+  gtk_text_layout_get_iter_at_line (layout, &line_start, display->line, 0);
+
+  line_end = line_start;
+  if (!gtk_text_iter_ends_line (&line_end))
+    gtk_text_iter_forward_to_line_end (&line_end);
+
+  return gtk_text_iter_compare (&line_start, end) <= 0 &&
+         gtk_text_iter_compare (start, &line_end) <= 0;
+}
+
 static void
 gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
-   */
-  if (layout->one_display_cache)
-    {
-      GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
-
-      gtk_text_layout_get_iter_at_line (layout, &line_start, line, 0);
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *l;
 
-      line_end = line_start;
-      if (!gtk_text_iter_ends_line (&line_end))
-	gtk_text_iter_forward_to_line_end (&line_end);
+  if (gtk_text_iter_compare (start, end) > 0)
+    {
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+    }
 
-      if (gtk_text_iter_compare (start, end) > 0)
-	{
-	  const GtkTextIter *tmp = start;
-	  start = end;
-	  end = tmp;
-	}
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
+   */
+  for (l = priv->line_display_lru.head; l != NULL; l = l->next)
+    {
+      GtkTextLineDisplay *display = l->data;
 
-      if (gtk_text_iter_compare (&line_start, end) <= 0 &&
-	  gtk_text_iter_compare (start, &line_end) <= 0)
-	{
-	  gtk_text_layout_invalidate_cache (layout, line, TRUE);
-	}
+      if (line_display_in_range (layout, display, start, end))
+        gtk_text_layout_invalidate_cache (layout, display->line, TRUE);
     }
 
+  if (layout->one_display_cache &&
+      line_display_in_range (layout, layout->one_display_cache, start, end))
+    gtk_text_layout_invalidate_cache (layout, layout->one_display_cache->line, TRUE);
+
   gtk_text_layout_invalidated (layout);
 }
 
@@ -1166,7 +1372,14 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
   line_data->width = display->width;
   line_data->height = display->height;
   line_data->valid = TRUE;
-  gtk_text_layout_free_line_display (layout, display);
+
+  /* Don't let validating offscreen lines push the displays
+   * of the visible lines out of the cache
+   */
+  if (display->size_only && line_display_is_cached (layout, display))
+    line_display_cache_remove (layout, display);
+  else
+    gtk_text_layout_free_line_display (layout, display);
 
   return line_data;
 }
@@ -2108,6 +2321,29 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
+static void
+line_display_cache_count (GtkTextLayout *layout,
+                          gboolean       hit)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (hit)
+    priv->line_display_hits++;
+  else
+    priv->line_display_misses++;
+
+#ifdef G_ENABLE_DEBUG
+  if ((gtk_get_debug_flags () & GTK_DEBUG_TEXT) &&
+      (priv->line_display_hits + priv->line_display_misses) % 1000 == 0)
+    g_message ("text layout %p: %u line displays cached, %u hits, %u misses (%.1f%% hit rate)",
+               layout,
+               g_queue_get_length (&priv->line_display_lru),
+               priv->line_display_hits,
+               priv->line_display_misses,
+               100.0 * priv->line_display_hits / (priv->line_display_hits + priv->line_display_misses));
+#endif
+}
+
 GtkTextLineDisplay *
 gtk_text_layout_get_line_display (GtkTextLayout *layout,
                                   GtkTextLine   *line,
@@ -2133,24 +2369,26 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   
   g_return_val_if_fail (line != NULL, NULL);
 
-  if (layout->one_display_cache)
+  display = line_display_cache_lookup (layout, line);
+  if (display)
     {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
+      if (size_only || !display->size_only)
 	{
+          line_display_cache_count (layout, TRUE);
 	  if (!size_only)
-            update_text_display_cursors (layout, line, layout->one_display_cache);
-	  return layout->one_display_cache;
+            update_text_display_cursors (layout, line, display);
+          line_display_cache_insert (layout, display);
+	  return display;
 	}
       else
         {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
+          line_display_cache_remove (layout, display);
         }
     }
 
-  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
+  line_display_cache_count (layout, FALSE);
+
+  DV (g_print ("creating line display (%s)\n", G_STRLOC));
 
   display = g_slice_new0 (GtkTextLineDisplay);
 
@@ -2469,7 +2707,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   if (tags != NULL)
     g_ptr_array_free (tags, TRUE);
 
-  layout->one_display_cache = display;
+  line_display_cache_insert (layout, display);
 
   if (saw_widget)
     allocate_child_widgets (layout, display);
@@ -2481,22 +2719,8 @@ void
 gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                    GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
-    {
-      if (display->layout)
-        g_object_unref (display->layout);
-
-      if (display->cursors)
-        g_array_free (display->cursors, TRUE);
-
-      if (display->pg_bg_color)
-        gdk_color_free (display->pg_bg_color);
-
-      if (display->pg_bg_rgba)
-        gdk_rgba_free (display->pg_bg_rgba);
-
-      g_slice_free (GtkTextLineDisplay, display);
-    }
+  if (!line_display_is_cached (layout, display))
+    line_display_free (display);
 }
 
 /* Functions to convert iter <=> index for the line of a GtkTextLineDisplay
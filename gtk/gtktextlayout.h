@@ -144,8 +144,9 @@ struct _GtkTextLayout
    * over long runs with the same style. */
   GtkTextAttributes *one_style_cache;
 
-  /* A cache of one line display. Getting the same line
-   * many times in a row is the most common case.
+  /* The display of the last line that had no line data yet,
+   * the displays of all other lines are kept in a cache of
+   * recently used displays.
    */
   GtkTextLineDisplay *one_display_cache;
 
@@ -259,6 +260,9 @@ struct _GtkTextLineDisplay
 
 #ifdef GTK_COMPILATION
 extern G_GNUC_INTERNAL PangoAttrType gtk_text_attr_appearance_type;
+
+void _gtk_text_layout_set_line_display_cache_size (GtkTextLayout *layout,
+                                                   guint          n_lines);
 #endif
 
 GDK_AVAILABLE_IN_ALL
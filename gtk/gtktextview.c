@@ -120,6 +120,9 @@
 
 #define SPACE_FOR_CURSOR 1
 
+/* How long the incremental validation may run per idle, in microseconds */
+#define INCREMENTAL_VALIDATE_TIME 8000
+
 #define GTK_TEXT_VIEW_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_TEXT_VIEW, GtkTextViewPrivate))
 
 typedef struct _GtkTextWindow GtkTextWindow;
@@ -3931,10 +3934,19 @@ incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
   gboolean result = TRUE;
+  gint64 end_time;
 
   DV(g_print(G_STRLOC"\n"));
-  
-  gtk_text_layout_validate (text_view->priv->layout, 2000);
+
+  /* Validate as much as fits in the time slice, the fixed
+   * pixel amount alone left large buffers invalid for a long
+   * time due to the overhead of each idle.
+   */
+  end_time = g_get_monotonic_time () + INCREMENTAL_VALIDATE_TIME;
+  do
+    gtk_text_layout_validate (text_view->priv->layout, 2000);
+  while (!gtk_text_layout_is_valid (text_view->priv->layout) &&
+         g_get_monotonic_time () < end_time);
 
   gtk_text_view_update_adjustments (text_view);
   
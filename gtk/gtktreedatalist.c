@@ -34,6 +34,20 @@ _gtk_tree_data_list_alloc (void)
   return list;
 }
 
+static void
+_gtk_tree_data_list_node_clear (GtkTreeDataList *list,
+                                GType            type)
+{
+  if (g_type_is_a (type, G_TYPE_STRING))
+    g_free ((gchar *) list->data.v_pointer);
+  else if (g_type_is_a (type, G_TYPE_OBJECT) && list->data.v_pointer != NULL)
+    g_object_unref (list->data.v_pointer);
+  else if (g_type_is_a (type, G_TYPE_BOXED) && list->data.v_pointer != NULL)
+    g_boxed_free (type, (gpointer) list->data.v_pointer);
+  else if (g_type_is_a (type, G_TYPE_VARIANT) && list->data.v_pointer != NULL)
+    g_variant_unref ((gpointer) list->data.v_pointer);
+}
+
 void
 _gtk_tree_data_list_free (GtkTreeDataList *list,
 			  GType           *column_headers)
@@ -46,14 +60,7 @@ _gtk_tree_data_list_free (GtkTreeDataList *list,
   while (tmp)
     {
       next = tmp->next;
-      if (g_type_is_a (column_headers [i], G_TYPE_STRING))
-	g_free ((gchar *) tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_OBJECT) && tmp->data.v_pointer != NULL)
-	g_object_unref (tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_BOXED) && tmp->data.v_pointer != NULL)
-	g_boxed_free (column_headers [i], (gpointer) tmp->data.v_pointer);
-      else if (g_type_is_a (column_headers [i], G_TYPE_VARIANT) && tmp->data.v_pointer != NULL)
-	g_variant_unref ((gpointer) tmp->data.v_pointer);
+      _gtk_tree_data_list_node_clear (tmp, column_headers[i]);
 
       g_slice_free (GtkTreeDataList, tmp);
       i++;
@@ -61,6 +68,58 @@ _gtk_tree_data_list_free (GtkTreeDataList *list,
     }
 }
 
+/* row allocation
+ *
+ * A row keeps the nodes for all columns in a single block, so that
+ * a column can be looked up by index instead of walking the list.
+ * The next pointers of the nodes in a row are unused and NULL.
+ */
+GtkTreeDataList *
+_gtk_tree_data_list_row_new (gint n_columns)
+{
+  return g_slice_alloc0 (n_columns * sizeof (GtkTreeDataList));
+}
+
+void
+_gtk_tree_data_list_row_free (GtkTreeDataList *row,
+                              gint             n_columns,
+                              GType           *column_headers)
+{
+  gint i;
+
+  if (row == NULL)
+    return;
+
+  for (i = 0; i < n_columns; i++)
+    _gtk_tree_data_list_node_clear (&row[i], column_headers[i]);
+
+  g_slice_free1 (n_columns * sizeof (GtkTreeDataList), row);
+}
+
+GtkTreeDataList *
+_gtk_tree_data_list_row_copy (GtkTreeDataList *row,
+                              gint             n_columns,
+                              GType           *column_headers)
+{
+  GtkTreeDataList *new_row;
+  GtkTreeDataList *node;
+  gint i;
+
+  if (row == NULL)
+    return NULL;
+
+  new_row = _gtk_tree_data_list_row_new (n_columns);
+
+  for (i = 0; i < n_columns; i++)
+    {
+      node = _gtk_tree_data_list_node_copy (&row[i], column_headers[i]);
+      new_row[i].data = node->data;
+      g_slice_free (GtkTreeDataList, node);
+    }
+
+  return new_row;
+}
+
 gboolean
 _gtk_tree_data_list_check_type (GType type)
 {
@@ -316,6 +375,62 @@ _gtk_tree_data_list_node_copy (GtkTreeDataList *list,
   return new_list;
 }
 
+#define COMPARE(a, b) ((a) < (b) ? -1 : ((a) == (b) ? 0 : 1))
+
+/* Compares two nodes the same way _gtk_tree_data_list_compare_func()
+ * compares their values, without going through #GValues.
+ */
+gint
+_gtk_tree_data_list_node_compare (GtkTreeDataList *a,
+                                  GtkTreeDataList *b,
+                                  GType            type)
+{
+  const gchar *stra, *strb;
+
+  switch (get_fundamental_type (type))
+    {
+    case G_TYPE_BOOLEAN:
+      return COMPARE (a->data.v_int != FALSE, b->data.v_int != FALSE);
+    case G_TYPE_CHAR:
+      return COMPARE ((gint8) a->data.v_char, (gint8) b->data.v_char);
+    case G_TYPE_UCHAR:
+      return COMPARE (a->data.v_uchar, b->data.v_uchar);
+    case G_TYPE_INT:
+    case G_TYPE_ENUM:
+      return COMPARE (a->data.v_int, b->data.v_int);
+    case G_TYPE_UINT:
+    case G_TYPE_FLAGS:
+      return COMPARE (a->data.v_uint, b->data.v_uint);
+    case G_TYPE_LONG:
+      return COMPARE (a->data.v_long, b->data.v_long);
+    case G_TYPE_ULONG:
+      return COMPARE (a->data.v_ulong, b->data.v_ulong);
+    case G_TYPE_INT64:
+      return COMPARE (a->data.v_int64, b->data.v_int64);
+    case G_TYPE_UINT64:
+      return COMPARE (a->data.v_uint64, b->data.v_uint64);
+    case G_TYPE_FLOAT:
+      return COMPARE (a->data.v_float, b->data.v_float);
+    case G_TYPE_DOUBLE:
+      return COMPARE (a->data.v_double, b->data.v_double);
+    case G_TYPE_STRING:
+      stra = a->data.v_pointer;
+      strb = b->data.v_pointer;
+      if (stra == NULL) stra = "";
+      if (strb == NULL) strb = "";
+      return g_utf8_collate (stra, strb);
+    case G_TYPE_VARIANT:
+    case G_TYPE_POINTER:
+    case G_TYPE_BOXED:
+    case G_TYPE_OBJECT:
+    default:
+      g_warning ("Attempting to sort on invalid type %s\n", g_type_name (type));
+      return FALSE;
+    }
+}
+
+#undef COMPARE
+
 gint
 _gtk_tree_data_list_compare_func (GtkTreeModel *model,
 				  GtkTreeIter  *a,
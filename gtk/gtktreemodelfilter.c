@@ -4279,6 +4279,150 @@ gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
                           filter);
 }
 
+static gboolean
+gtk_tree_model_filter_child_path_is_visible (GtkTreeModelFilter *filter,
+                                             GtkTreePath        *c_path)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gboolean visible = FALSE;
+
+  path = gtk_real_tree_model_filter_convert_child_path_to_path (filter,
+                                                                c_path,
+                                                                FALSE,
+                                                                FALSE);
+  if (path)
+    {
+      gtk_tree_model_filter_get_iter_full (GTK_TREE_MODEL (filter),
+                                           &iter, path);
+      visible = FILTER_ELT (iter.user_data2)->visible_siter != NULL;
+      gtk_tree_path_free (path);
+    }
+
+  return visible;
+}
+
+static gboolean
+gtk_tree_model_filter_refilter_hidden_helper (GtkTreeModel *model,
+                                              GtkTreePath  *path,
+                                              GtkTreeIter  *iter,
+                                              gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+
+  /* Visible rows stay visible, so only look at the hidden ones */
+  if (!gtk_tree_model_filter_child_path_is_visible (filter, path))
+    gtk_tree_model_filter_row_changed (model, path, iter, data);
+
+  return FALSE;
+}
+
+/* Collects the child iters of the visible rows in @level and the
+ * levels below it that are not visible anymore. Nothing is changed
+ * yet, so that the cache stays intact while it is being walked.
+ * Parents come before their children in @hidden.
+ */
+static void
+gtk_tree_model_filter_collect_hidden (GtkTreeModelFilter *filter,
+                                      FilterLevel        *level,
+                                      GArray             *hidden)
+{
+  GSequenceIter *siter;
+  GtkTreeIter iter;
+  GtkTreeIter c_iter;
+
+  iter.stamp = filter->priv->stamp;
+  iter.user_data = level;
+
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       !g_sequence_iter_is_end (siter);
+       siter = g_sequence_iter_next (siter))
+    {
+      FilterElt *elt = g_sequence_get (siter);
+
+      if (elt->visible_siter)
+        {
+          iter.user_data2 = elt;
+          gtk_tree_model_filter_convert_iter_to_child_iter (filter, &c_iter, &iter);
+
+          if (!gtk_tree_model_filter_visible (filter, &c_iter))
+            g_array_append_val (hidden, c_iter);
+        }
+
+      /* Levels below hidden rows are cached as well, when the
+       * visibility of a row depends on its children.
+       */
+      if (elt->children)
+        gtk_tree_model_filter_collect_hidden (filter, elt->children, hidden);
+    }
+}
+
+/**
+ * gtk_tree_model_filter_refilter_with_change:
+ * @filter: A #GtkTreeModelFilter
+ * @change: how the visibility of the rows has changed
+ *
+ * Re-evaluates whether rows are visible or not, like
+ * gtk_tree_model_filter_refilter(), using @change to skip the rows
+ * whose state is known not to have changed.
+ *
+ * If @change is %GTK_TREE_MODEL_FILTER_CHANGE_MORE_STRICT, only the rows
+ * that are currently visible are checked. As the cache of the filter
+ * only holds rows that have been visible, this does not need to walk
+ * the whole child model. If it is
+ * %GTK_TREE_MODEL_FILTER_CHANGE_LESS_STRICT, only the rows that are
+ * currently hidden are checked.
+ *
+ * Unlike gtk_tree_model_filter_refilter(), this only emits signals for
+ * rows that are shown or hidden, not ::row-changed for every row.
+ *
+ * Since: 3.10
+ */
+void
+gtk_tree_model_filter_refilter_with_change (GtkTreeModelFilter       *filter,
+                                            GtkTreeModelFilterChange  change)
+{
+  GArray *hidden;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+
+  switch (change)
+    {
+    case GTK_TREE_MODEL_FILTER_CHANGE_MORE_STRICT:
+      if (filter->priv->root == NULL)
+        return;
+
+      hidden = g_array_new (FALSE, FALSE, sizeof (GtkTreeIter));
+      gtk_tree_model_filter_collect_hidden (filter,
+                                            FILTER_LEVEL (filter->priv->root),
+                                            hidden);
+
+      /* Remove children before their parents, row_changed() will
+       * notice rows that have gone away with their parent already.
+       */
+      for (i = (gint) hidden->len - 1; i >= 0; i--)
+        gtk_tree_model_filter_row_changed (filter->priv->child_model,
+                                           NULL,
+                                           &g_array_index (hidden, GtkTreeIter, i),
+                                           filter);
+
+      g_array_free (hidden, TRUE);
+      break;
+
+    case GTK_TREE_MODEL_FILTER_CHANGE_LESS_STRICT:
+      gtk_tree_model_foreach (filter->priv->child_model,
+                              gtk_tree_model_filter_refilter_hidden_helper,
+                              filter);
+      break;
+
+    case GTK_TREE_MODEL_FILTER_CHANGE_DIFFERENT:
+    default:
+      gtk_tree_model_filter_refilter (filter);
+      break;
+    }
+}
+
 /**
  * gtk_tree_model_filter_clear_cache:
  * @filter: A #GtkTreeModelFilter.
@@ -72,6 +72,30 @@ typedef void (* GtkTreeModelFilterModifyFunc) (GtkTreeModel *model,
                                                gint          column,
                                                gpointer      data);
 
+/**
+ * GtkTreeModelFilterChange:
+ * @GTK_TREE_MODEL_FILTER_CHANGE_DIFFERENT: The visibility of any row
+ *   may have changed.
+ * @GTK_TREE_MODEL_FILTER_CHANGE_LESS_STRICT: Rows may have become
+ *   visible, but no visible row has become hidden. This is the case
+ *   when a search string is shortened, for example.
+ * @GTK_TREE_MODEL_FILTER_CHANGE_MORE_STRICT: Rows may have become
+ *   hidden, but no hidden row has become visible. This is the case
+ *   when a search string is extended, for example.
+ *
+ * Describes how the result of the visible function of a
+ * #GtkTreeModelFilter has changed, see
+ * gtk_tree_model_filter_refilter_with_change().
+ *
+ * Since: 3.10
+ */
+typedef enum
+{
+  GTK_TREE_MODEL_FILTER_CHANGE_DIFFERENT,
+  GTK_TREE_MODEL_FILTER_CHANGE_LESS_STRICT,
+  GTK_TREE_MODEL_FILTER_CHANGE_MORE_STRICT
+} GtkTreeModelFilterChange;
+
 typedef struct _GtkTreeModelFilter          GtkTreeModelFilter;
 typedef struct _GtkTreeModelFilterClass     GtkTreeModelFilterClass;
 typedef struct _GtkTreeModelFilterPrivate   GtkTreeModelFilterPrivate;
@@ -148,6 +172,9 @@ GtkTreePath  *gtk_tree_model_filter_convert_path_to_child_path (GtkTreeModelFilt
 /* extras */
 GDK_AVAILABLE_IN_ALL
 void          gtk_tree_model_filter_refilter                   (GtkTreeModelFilter           *filter);
+GDK_AVAILABLE_IN_3_10
+void          gtk_tree_model_filter_refilter_with_change       (GtkTreeModelFilter           *filter,
+                                                                GtkTreeModelFilterChange      change);
 GDK_AVAILABLE_IN_ALL
 void          gtk_tree_model_filter_clear_cache                (GtkTreeModelFilter           *filter);
 
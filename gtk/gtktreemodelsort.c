@@ -1898,6 +1898,330 @@ gtk_tree_model_sort_offset_compare_func (gconstpointer a,
   return retval;
 }
 
+/* Sorting on extracted keys
+ *
+ * When a column is sorted with the default compare function, every
+ * value is fetched from the child model once up front, instead of
+ * twice per comparison.  Strings are turned into collation keys, so
+ * comparing them is a plain strcmp() rather than a g_utf8_collate().
+ * Neither making the keys nor sorting them touches the child model,
+ * so big levels are split into chunks that are sorted on a shared
+ * thread pool and then merged.
+ */
+#define SORT_KEYS_MIN_CHUNK 8192
+
+typedef struct _SortKey SortKey;
+typedef struct _SortKeyChunk SortKeyChunk;
+typedef struct _SortKeyJob SortKeyJob;
+
+struct _SortKey
+{
+  SortElt         *elt;
+  GtkTreeDataList  value; /* holds the collation key for strings */
+};
+
+struct _SortKeyJob
+{
+  GMutex  mutex;
+  GCond   cond;
+  guint   pending;
+};
+
+struct _SortKeyChunk
+{
+  SortKeyJob  *job;
+  SortKey     *keys;
+  SortKey     *tmp;
+  gint         n_keys;
+  GType        type;
+  gboolean     is_string;
+  GtkSortType  order;
+};
+
+static gboolean
+sort_key_type_supported (GType type)
+{
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+    case G_TYPE_STRING:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
+static inline gint
+sort_key_compare (const SortKey      *a,
+                  const SortKey      *b,
+                  const SortKeyChunk *chunk)
+{
+  gint retval;
+
+  if (chunk->is_string)
+    retval = strcmp (a->value.data.v_pointer, b->value.data.v_pointer);
+  else
+    retval = _gtk_tree_data_list_node_compare ((GtkTreeDataList *) &a->value,
+                                               (GtkTreeDataList *) &b->value,
+                                               chunk->type);
+
+  if (chunk->order == GTK_SORT_DESCENDING)
+    {
+      if (retval > 0)
+	retval = -1;
+      else if (retval < 0)
+	retval = 1;
+    }
+
+  return retval;
+}
+
+/* Merges the sorted runs keys[0, n1) and keys[n1, n1 + n2) */
+static void
+sort_keys_merge (SortKey            *keys,
+                 gint                n1,
+                 gint                n2,
+                 SortKey            *tmp,
+                 const SortKeyChunk *chunk)
+{
+  gint i, j, k;
+
+  i = 0;
+  j = n1;
+  k = 0;
+
+  while (i < n1 && j < n1 + n2)
+    {
+      if (sort_key_compare (&keys[j], &keys[i], chunk) < 0)
+        tmp[k++] = keys[j++];
+      else
+        tmp[k++] = keys[i++];
+    }
+
+  /* whatever is left of the second run is in place already */
+  memcpy (&tmp[k], &keys[i], (n1 - i) * sizeof (SortKey));
+  k += n1 - i;
+
+  memcpy (keys, tmp, k * sizeof (SortKey));
+}
+
+/* A stable merge sort, so equal rows keep their current order */
+static void
+sort_keys_sort (SortKey            *keys,
+                gint                n_keys,
+                SortKey            *tmp,
+                const SortKeyChunk *chunk)
+{
+  gint half;
+
+  if (n_keys <= 16)
+    {
+      gint i, j;
+
+      for (i = 1; i < n_keys; i++)
+        {
+          SortKey key = keys[i];
+
+          for (j = i; j > 0 && sort_key_compare (&key, &keys[j - 1], chunk) < 0; j--)
+            keys[j] = keys[j - 1];
+
+          keys[j] = key;
+        }
+
+      return;
+    }
+
+  half = n_keys / 2;
+  sort_keys_sort (keys, half, tmp, chunk);
+  sort_keys_sort (keys + half, n_keys - half, tmp + half, chunk);
+  sort_keys_merge (keys, half, n_keys - half, tmp, chunk);
+}
+
+static gpointer
+sort_key_chunk_run (gpointer data)
+{
+  SortKeyChunk *chunk = data;
+  gint i;
+
+  if (chunk->is_string)
+    {
+      for (i = 0; i < chunk->n_keys; i++)
+        {
+          gchar *str = chunk->keys[i].value.data.v_pointer;
+
+          chunk->keys[i].value.data.v_pointer = g_utf8_collate_key (str ? str : "", -1);
+          g_free (str);
+        }
+    }
+
+  sort_keys_sort (chunk->keys, chunk->n_keys, chunk->tmp, chunk);
+
+  return NULL;
+}
+
+static void
+sort_key_chunk_thread_func (gpointer data,
+                            gpointer user_data)
+{
+  SortKeyChunk *chunk = data;
+  SortKeyJob *job = chunk->job;
+
+  sort_key_chunk_run (chunk);
+
+  g_mutex_lock (&job->mutex);
+  job->pending--;
+  if (job->pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+static GThreadPool *
+get_sort_key_pool (void)
+{
+  static GThreadPool *pool = NULL;
+
+  if (g_once_init_enter (&pool))
+    {
+      GThreadPool *new_pool;
+
+      new_pool = g_thread_pool_new (sort_key_chunk_thread_func,
+                                    NULL,
+                                    g_get_num_processors (),
+                                    FALSE,
+                                    NULL);
+
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  return pool;
+}
+
+static gboolean
+gtk_tree_model_sort_sort_level_by_keys (GtkTreeModelSort *tree_model_sort,
+                                        SortLevel        *level,
+                                        SortData         *data)
+{
+  GtkTreeModelSortPrivate *priv = tree_model_sort->priv;
+  GSequenceIter *siter, *end_siter;
+  SortKey *keys, *tmp;
+  SortKeyChunk *chunks;
+  SortKeyJob job;
+  gint *starts;
+  gint column, n_keys, n_chunks;
+  gint i, c, width;
+  GType type;
+
+  column = GPOINTER_TO_INT (data->sort_data);
+  type = gtk_tree_model_get_column_type (priv->child_model, column);
+  if (!sort_key_type_supported (type))
+    return FALSE;
+
+  n_keys = g_sequence_get_length (level->seq);
+  keys = g_new0 (SortKey, n_keys);
+  tmp = g_new (SortKey, n_keys);
+
+  /* The child model may only be used from this thread */
+  i = 0;
+  end_siter = g_sequence_get_end_iter (level->seq);
+  for (siter = g_sequence_get_begin_iter (level->seq);
+       siter != end_siter;
+       siter = g_sequence_iter_next (siter))
+    {
+      SortElt *elt = g_sequence_get (siter);
+      GValue value = G_VALUE_INIT;
+      GtkTreeIter iter;
+
+      if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+        iter = elt->iter;
+      else
+        {
+          data->parent_path_indices [data->parent_path_depth-1] = elt->offset;
+          gtk_tree_model_get_iter (GTK_TREE_MODEL (priv->child_model), &iter, data->parent_path);
+        }
+
+      gtk_tree_model_get_value (priv->child_model, &iter, column, &value);
+
+      keys[i].elt = elt;
+      _gtk_tree_data_list_value_to_node (&keys[i].value, &value);
+      g_value_unset (&value);
+      i++;
+    }
+
+  n_chunks = CLAMP (n_keys / SORT_KEYS_MIN_CHUNK, 1, (gint) g_get_num_processors ());
+  chunks = g_new (SortKeyChunk, n_chunks);
+  starts = g_new (gint, n_chunks + 1);
+
+  for (c = 0; c <= n_chunks; c++)
+    starts[c] = (gint) ((gint64) n_keys * c / n_chunks);
+
+  for (c = 0; c < n_chunks; c++)
+    {
+      chunks[c].job = &job;
+      chunks[c].keys = keys + starts[c];
+      chunks[c].tmp = tmp + starts[c];
+      chunks[c].n_keys = starts[c + 1] - starts[c];
+      chunks[c].type = type;
+      chunks[c].is_string = G_TYPE_FUNDAMENTAL (type) == G_TYPE_STRING;
+      chunks[c].order = priv->order;
+    }
+
+  g_mutex_init (&job.mutex);
+  g_cond_init (&job.cond);
+
+  job.pending = n_chunks - 1;
+  for (c = 1; c < n_chunks; c++)
+    g_thread_pool_push (get_sort_key_pool (), &chunks[c], NULL);
+
+  sort_key_chunk_run (&chunks[0]);
+
+  g_mutex_lock (&job.mutex);
+  while (job.pending > 0)
+    g_cond_wait (&job.cond, &job.mutex);
+  g_mutex_unlock (&job.mutex);
+
+  g_mutex_clear (&job.mutex);
+  g_cond_clear (&job.cond);
+
+  /* Merge the sorted chunks pairwise */
+  for (width = 1; width < n_chunks; width *= 2)
+    {
+      for (c = 0; c + width < n_chunks; c += 2 * width)
+        sort_keys_merge (keys + starts[c],
+                         starts[c + width] - starts[c],
+                         starts[MIN (c + 2 * width, n_chunks)] - starts[c + width],
+                         tmp + starts[c],
+                         &chunks[0]);
+    }
+
+  /* Moving every element to the end in turn leaves them in order */
+  for (i = 0; i < n_keys; i++)
+    {
+      g_sequence_move (keys[i].elt->siter, end_siter);
+
+      if (chunks[0].is_string)
+        g_free (keys[i].value.data.v_pointer);
+    }
+
+  g_free (starts);
+  g_free (chunks);
+  g_free (tmp);
+  g_free (keys);
+
+  return TRUE;
+}
+
 static void
 gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
 				SortLevel        *level,
@@ -1946,7 +2270,8 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
   if (data.sort_func == NO_SORT_FUNC)
     g_sequence_sort (level->seq, gtk_tree_model_sort_offset_compare_func,
                      &data);
-  else
+  else if (data.sort_func != _gtk_tree_data_list_compare_func ||
+           !gtk_tree_model_sort_sort_level_by_keys (tree_model_sort, level, &data))
     g_sequence_sort (level->seq, gtk_tree_model_sort_compare_func, &data);
 
   free_sort_data (&data);
@@ -534,6 +534,7 @@ enum
   EXPAND_COLLAPSE_CURSOR_ROW,
   SELECT_CURSOR_PARENT,
   START_INTERACTIVE_SEARCH,
+  ROWS_VALIDATED,
   LAST_SIGNAL
 };
 
@@ -1503,6 +1504,29 @@ gtk_tree_view_class_init (GtkTreeViewClass *class)
 		  _gtk_marshal_BOOLEAN__VOID,
 		  G_TYPE_BOOLEAN, 0);
 
+  /**
+   * GtkTreeView::rows-validated:
+   * @tree_view: the object on which the signal is emitted
+   *
+   * The tree view measures the height of rows that are not visible
+   * in the background, a few at a time. The ::rows-validated signal
+   * is emitted when this is done and the height of every row, and
+   * thus the size of the tree view, is known.
+   *
+   * It is emitted again when rows become invalid, for example
+   * because they were inserted or changed, and have been measured.
+   *
+   * Since: 3.10
+   */
+  tree_view_signals[ROWS_VALIDATED] =
+    g_signal_new (I_("rows-validated"),
+		  G_TYPE_FROM_CLASS (o_class),
+		  G_SIGNAL_RUN_LAST,
+		  0,
+		  NULL, NULL,
+		  _gtk_marshal_VOID__VOID,
+		  G_TYPE_NONE, 0);
+
   /* Key bindings */
   gtk_tree_view_add_move_binding (binding_set, GDK_KEY_Up, 0, TRUE,
 				  GTK_MOVEMENT_DISPLAY_LINES, -1);
@@ -6652,6 +6676,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
   gint y = -1;
   gint prev_height = -1;
+  gint total_height = 0;
   gboolean fixed_height = TRUE;
 
   g_assert (tree_view);
@@ -6757,6 +6782,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 	    prev_height = height;
 	  else if (prev_height != height)
 	    fixed_height = FALSE;
+          total_height += height;
 	}
 
       i++;
@@ -6765,8 +6791,14 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
   if (!tree_view->priv->fixed_height_check)
    {
+     /* If the rows differ in height, guess the height of the rows that
+      * haven't been measured yet from the ones that have. Otherwise the
+      * unmeasured rows count as 0 pixels high and the view, and with it
+      * the scrollbar, keeps growing until validation is done. */
      if (fixed_height)
        _gtk_rbtree_set_fixed_height (tree_view->priv->tree, prev_height, FALSE);
+     else
+       _gtk_rbtree_set_fixed_height (tree_view->priv->tree, (total_height + i / 2) / i, FALSE);
 
      tree_view->priv->fixed_height_check = 1;
    }
@@ -6827,6 +6859,8 @@ validate_rows (GtkTreeView *tree_view)
     {
       g_source_remove (tree_view->priv->validate_rows_timer);
       tree_view->priv->validate_rows_timer = 0;
+
+      g_signal_emit (tree_view, tree_view_signals[ROWS_VALIDATED], 0);
     }
 
   return retval;
@@ -6835,16 +6869,7 @@ validate_rows (GtkTreeView *tree_view)
 static gboolean
 validate_rows_handler (GtkTreeView *tree_view)
 {
-  gboolean retval;
-
-  retval = do_validate_rows (tree_view, TRUE);
-  if (! retval && tree_view->priv->validate_rows_timer)
-    {
-      g_source_remove (tree_view->priv->validate_rows_timer);
-      tree_view->priv->validate_rows_timer = 0;
-    }
-
-  return retval;
+  return validate_rows (tree_view);
 }
 
 static gboolean
@@ -9353,20 +9378,25 @@ gtk_tree_view_build_tree (GtkTreeView *tree_view,
 {
   GtkRBNode *temp = NULL;
   GtkTreePath *path = NULL;
+  GtkTreeIter count_iter;
+  guint n_rows = 0;
+
+  /* Count the rows first, so the whole level can be created at once
+   * instead of inserting and rebalancing row by row */
+  count_iter = *iter;
+  do
+    n_rows++;
+  while (gtk_tree_model_iter_next (tree_view->priv->model, &count_iter));
+
+  if (tree_view->priv->fixed_height > 0)
+    _gtk_rbtree_fill (tree, n_rows, tree_view->priv->fixed_height, TRUE);
+  else
+    _gtk_rbtree_fill (tree, n_rows, 0, FALSE);
 
   do
     {
       gtk_tree_model_ref_node (tree_view->priv->model, iter);
-      temp = _gtk_rbtree_insert_after (tree, temp, 0, FALSE);
-
-      if (tree_view->priv->fixed_height > 0)
-        {
-          if (GTK_RBNODE_FLAG_SET (temp, GTK_RBNODE_INVALID))
-	    {
-              _gtk_rbtree_node_set_height (tree, temp, tree_view->priv->fixed_height);
-	      _gtk_rbtree_node_mark_valid (tree, temp);
-	    }
-        }
+      temp = temp ? _gtk_rbtree_next (tree, temp) : _gtk_rbtree_first (tree);
 
       if (tree_view->priv->is_list)
         continue;
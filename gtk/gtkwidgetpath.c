@@ -20,7 +20,7 @@
 #include <string.h>
 
 #include "gtkwidget.h"
-#include "gtkwidgetpath.h"
+#include "gtkwidgetpathprivate.h"
 #include "gtkstylecontextprivate.h"
 
 /**
@@ -284,6 +284,139 @@ gtk_widget_path_length (const GtkWidgetPath *path)
   return path->elems->len;
 }
 
+static guint
+gtk_path_element_hash (const GtkPathElement *elem)
+{
+  guint i, hash;
+
+  hash = elem->type;
+  hash = (hash << 5) - hash + elem->name;
+  hash = (hash << 5) - hash + elem->sibling_index;
+
+  if (elem->siblings)
+    hash = (hash << 5) - hash + elem->siblings->elems->len;
+
+  if (elem->classes)
+    {
+      for (i = 0; i < elem->classes->len; i++)
+        hash = (hash << 5) - hash + g_array_index (elem->classes, GQuark, i);
+    }
+
+  /* regions are kept in a hash table, so only the count is order-independent */
+  if (elem->regions)
+    hash = (hash << 5) - hash + g_hash_table_size (elem->regions);
+
+  return hash;
+}
+
+static gboolean
+gtk_path_element_equal (const GtkPathElement *elem1,
+                        const GtkPathElement *elem2)
+{
+  guint n_classes1, n_classes2, n_regions1, n_regions2;
+
+  if (elem1->type != elem2->type ||
+      elem1->name != elem2->name ||
+      elem1->sibling_index != elem2->sibling_index)
+    return FALSE;
+
+  n_classes1 = elem1->classes ? elem1->classes->len : 0;
+  n_classes2 = elem2->classes ? elem2->classes->len : 0;
+  if (n_classes1 != n_classes2)
+    return FALSE;
+
+  /* classes are kept sorted, see gtk_widget_path_iter_add_class() */
+  if (n_classes1 > 0 &&
+      memcmp (elem1->classes->data, elem2->classes->data, n_classes1 * sizeof (GQuark)) != 0)
+    return FALSE;
+
+  n_regions1 = elem1->regions ? g_hash_table_size (elem1->regions) : 0;
+  n_regions2 = elem2->regions ? g_hash_table_size (elem2->regions) : 0;
+  if (n_regions1 != n_regions2)
+    return FALSE;
+
+  if (n_regions1 > 0)
+    {
+      GHashTableIter iter;
+      gpointer key, value, other;
+
+      g_hash_table_iter_init (&iter, elem1->regions);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          if (!g_hash_table_lookup_extended (elem2->regions, key, NULL, &other) ||
+              value != other)
+            return FALSE;
+        }
+    }
+
+  if (elem1->siblings != elem2->siblings)
+    {
+      if (elem1->siblings == NULL || elem2->siblings == NULL)
+        return FALSE;
+
+      if (!_gtk_widget_path_equal (elem1->siblings, elem2->siblings))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * _gtk_widget_path_hash:
+ * @path: a #GtkWidgetPath
+ *
+ * Computes a hash value for @path that is compatible with
+ * _gtk_widget_path_equal(), so paths can be used as hash table keys.
+ *
+ * Returns: the hash value
+ */
+guint
+_gtk_widget_path_hash (const GtkWidgetPath *path)
+{
+  guint i, hash = 0;
+
+  for (i = 0; i < path->elems->len; i++)
+    {
+      hash = (hash << 5) - hash +
+             gtk_path_element_hash (&g_array_index (path->elems, GtkPathElement, i));
+    }
+
+  return hash;
+}
+
+/*
+ * _gtk_widget_path_equal:
+ * @path1: a #GtkWidgetPath
+ * @path2: another #GtkWidgetPath
+ *
+ * Checks if two paths describe the same widget, including the names,
+ * classes and regions of all elements as well as their siblings.
+ * Two equal paths will always be matched by the same CSS selectors.
+ *
+ * Returns: %TRUE if the paths are equal
+ */
+gboolean
+_gtk_widget_path_equal (const GtkWidgetPath *path1,
+                        const GtkWidgetPath *path2)
+{
+  guint i;
+
+  if (path1 == path2)
+    return TRUE;
+
+  if (path1->elems->len != path2->elems->len)
+    return FALSE;
+
+  for (i = 0; i < path1->elems->len; i++)
+    {
+      if (!gtk_path_element_equal (&g_array_index (path1->elems, GtkPathElement, i),
+                                   &g_array_index (path2->elems, GtkPathElement, i)))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 /**
  * gtk_widget_path_to_string:
  * @path: the path
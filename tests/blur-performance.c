@@ -0,0 +1,211 @@
+/* -*- mode: C; c-basic-offset: 2; indent-tabs-mode: nil; -*- */
+
+/* Compares the blur used for CSS shadows against the exponential blur
+ * it replaced, at a range of radii. The blur code is private to GTK+,
+ * so it is compiled into this program directly.
+ */
+
+#include <cairo.h>
+#include <glib.h>
+#include <math.h>
+
+#include "gtk/gtkcairoblur.c"
+
+#include "variable.h"
+
+static int width = 512;
+static int height = 512;
+static int iterations = 20;
+
+static GOptionEntry options[] = {
+  { "width", 'w', 0, G_OPTION_ARG_INT, &width, "Surface width", "WIDTH" },
+  { "height", 'h', 0, G_OPTION_ARG_INT, &height, "Surface height", "HEIGHT" },
+  { "iterations", 'i', 0, G_OPTION_ARG_INT, &iterations, "Blurs per radius", "N" },
+  { NULL }
+};
+
+/* The exponential blur that was used before, for reference */
+
+static inline void
+expblur_inner (guchar *pixel,
+               gint   *zR,
+               gint   *zG,
+               gint   *zB,
+               gint   *zA,
+               gint    alpha,
+               gint    aprec,
+               gint    zprec)
+{
+  *zR += (alpha * ((pixel[0] << zprec) - *zR)) >> aprec;
+  *zG += (alpha * ((pixel[1] << zprec) - *zG)) >> aprec;
+  *zB += (alpha * ((pixel[2] << zprec) - *zB)) >> aprec;
+  *zA += (alpha * ((pixel[3] << zprec) - *zA)) >> aprec;
+
+  pixel[0] = *zR >> zprec;
+  pixel[1] = *zG >> zprec;
+  pixel[2] = *zB >> zprec;
+  pixel[3] = *zA >> zprec;
+}
+
+static void
+expblur_line (guchar *line,
+              gint    length,
+              gint    step,
+              gint    alpha,
+              gint    aprec,
+              gint    zprec)
+{
+  gint zR, zG, zB, zA;
+  gint i;
+
+  zR = line[0] << zprec;
+  zG = line[1] << zprec;
+  zB = line[2] << zprec;
+  zA = line[3] << zprec;
+
+  for (i = 0; i < length; i++)
+    expblur_inner (line + i * step, &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+
+  for (i = length - 2; i >= 0; i--)
+    expblur_inner (line + i * step, &zR, &zG, &zB, &zA, alpha, aprec, zprec);
+}
+
+static void
+expblur_surface (cairo_surface_t *surface,
+                 double           radius)
+{
+  guchar *pixels;
+  gint w, h, stride;
+  gint alpha, i;
+
+  cairo_surface_flush (surface);
+
+  pixels = cairo_image_surface_get_data (surface);
+  w = cairo_image_surface_get_width (surface);
+  h = cairo_image_surface_get_height (surface);
+  stride = cairo_image_surface_get_stride (surface);
+  alpha = (gint) ((1 << 16) * (1.0f - expf (-2.3f / (radius + 1.f))));
+
+  for (i = 0; i < h; i++)
+    expblur_line (pixels + i * stride, w, 4, alpha, 16, 7);
+  for (i = 0; i < w; i++)
+    expblur_line (pixels + i * 4, h, stride, alpha, 16, 7);
+
+  cairo_surface_mark_dirty (surface);
+}
+
+static void
+boxblur_surface (cairo_surface_t *surface,
+                 double           radius,
+                 guint            n_threads)
+{
+  cairo_surface_flush (surface);
+
+  _boxblur (cairo_image_surface_get_data (surface),
+            cairo_image_surface_get_width (surface),
+            cairo_image_surface_get_height (surface),
+            cairo_image_surface_get_stride (surface),
+            4,
+            get_box_filter_size (radius),
+            n_threads);
+
+  cairo_surface_mark_dirty (surface);
+}
+
+static void
+draw_shadow_source (cairo_surface_t *surface)
+{
+  cairo_t *cr;
+
+  cr = cairo_create (surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  cairo_paint (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+  cairo_set_source_rgba (cr, 0, 0, 0, 0.8);
+  cairo_rectangle (cr, width / 4, height / 4, width / 2, height / 2);
+  cairo_fill (cr);
+  cairo_destroy (cr);
+}
+
+/* Returns the mean time of one blur in milliseconds */
+static double
+measure (cairo_surface_t *surface,
+         double           radius,
+         guint            n_threads,
+         double          *deviation)
+{
+  Variable stats = VARIABLE_INIT;
+  gint64 start;
+  int i;
+
+  for (i = 0; i < iterations; i++)
+    {
+      draw_shadow_source (surface);
+
+      start = g_get_monotonic_time ();
+      if (n_threads == 0)
+        expblur_surface (surface, radius);
+      else
+        boxblur_surface (surface, radius, n_threads);
+      variable_add (&stats, (g_get_monotonic_time () - start) / 1000.);
+    }
+
+  *deviation = variable_standard_deviation (&stats);
+
+  return variable_mean (&stats);
+}
+
+int
+main (int argc, char **argv)
+{
+  static const double radii[] = { 2, 4, 8, 16, 32, 64 };
+  GOptionContext *context;
+  GError *error = NULL;
+  cairo_surface_t *surface;
+  double exp_ms, box_ms, threaded_ms;
+  double exp_dev, box_dev, threaded_dev;
+  guint n_threads;
+  guint i;
+
+  context = g_option_context_new ("");
+  g_option_context_add_main_entries (context, options, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("Option parsing failed: %s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  n_threads = g_get_num_processors ();
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+
+  g_print ("%dx%d surface, %d iterations, times in ms\n", width, height, iterations);
+  g_print ("%6s %16s %16s %16s\n", "radius", "exponential", "box", "box (threads)");
+
+  for (i = 0; i < G_N_ELEMENTS (radii); i++)
+    {
+      exp_ms = measure (surface, radii[i], 0, &exp_dev);
+      box_ms = measure (surface, radii[i], 1, &box_dev);
+      threaded_ms = measure (surface, radii[i], n_threads, &threaded_dev);
+
+      g_print ("%6g %8.3f (%5.3f) %8.3f (%5.3f) %8.3f (%5.3f)\n",
+               radii[i],
+               exp_ms, exp_dev,
+               box_ms, box_dev,
+               threaded_ms, threaded_dev);
+    }
+
+  g_print ("box blur: %s, %u threads\n",
+#if defined(__SSE2__)
+           "SSE2",
+#elif defined(GTK_CAIRO_BLUR_NEON)
+           "NEON",
+#else
+           "scalar",
+#endif
+           n_threads);
+
+  cairo_surface_destroy (surface);
+
+  return 0;
+}
@@ -65,7 +65,83 @@ scroll_viewport (GtkWidget     *viewport,
   return TRUE;
 }
 
+static GtkListStore *
+create_list_store (void)
+{
+  GtkIconTheme *icon_theme;
+  GtkListStore *store;
+  GdkPixbuf *pixbuf;
+  int i;
+
+  icon_theme = gtk_icon_theme_get_default ();
+  pixbuf = gtk_icon_theme_load_icon (icon_theme, "text-x-generic", 48, 0, NULL);
+
+  store = gtk_list_store_new (2, G_TYPE_STRING, GDK_TYPE_PIXBUF);
+  for (i = 0; i < 2000; i++)
+    {
+      gchar *text = g_strdup_printf ("Item %d, with some more text to draw", i);
+
+      gtk_list_store_insert_with_values (store, NULL, -1,
+                                         0, text,
+                                         1, pixbuf,
+                                         -1);
+      g_free (text);
+    }
+
+  if (pixbuf)
+    g_object_unref (pixbuf);
+
+  return store;
+}
+
+static GtkWidget *
+create_tree_view (void)
+{
+  GtkListStore *store;
+  GtkWidget *tree_view;
+  int i;
+
+  store = create_list_store ();
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  g_object_unref (store);
+
+  for (i = 0; i < 4; i++)
+    {
+      gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view), -1, "Icon",
+                                                   gtk_cell_renderer_pixbuf_new (),
+                                                   "pixbuf", 1,
+                                                   NULL);
+      gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view), -1, "Text",
+                                                   gtk_cell_renderer_text_new (),
+                                                   "text", 0,
+                                                   NULL);
+    }
+
+  return tree_view;
+}
+
+static GtkWidget *
+create_icon_view (void)
+{
+  GtkListStore *store;
+  GtkWidget *icon_view;
+
+  store = create_list_store ();
+  icon_view = gtk_icon_view_new_with_model (GTK_TREE_MODEL (store));
+  g_object_unref (store);
+
+  gtk_icon_view_set_text_column (GTK_ICON_VIEW (icon_view), 0);
+  gtk_icon_view_set_pixbuf_column (GTK_ICON_VIEW (icon_view), 1);
+  gtk_icon_view_set_item_width (GTK_ICON_VIEW (icon_view), 120);
+
+  return icon_view;
+}
+
+static gchar *widget_type = NULL;
+
 static GOptionEntry options[] = {
+  { "widget", 'w', 0, G_OPTION_ARG_STRING, &widget_type,
+    "Widget to scroll: viewport (default), treeview or iconview", "WIDGET" },
   { NULL }
 };
 
@@ -98,18 +174,31 @@ main (int argc, char **argv)
   scrolled_window = gtk_scrolled_window_new (NULL, NULL);
   gtk_container_add (GTK_CONTAINER (window), scrolled_window);
 
-  viewport = gtk_viewport_new (NULL, NULL);
-  gtk_container_add (GTK_CONTAINER (scrolled_window), viewport);
-
-  grid = gtk_grid_new ();
-  gtk_container_add (GTK_CONTAINER (viewport), grid);
-
-  for (i = 0; i < 4; i++)
+  if (g_strcmp0 (widget_type, "treeview") == 0)
+    {
+      viewport = create_tree_view ();
+      gtk_container_add (GTK_CONTAINER (scrolled_window), viewport);
+    }
+  else if (g_strcmp0 (widget_type, "iconview") == 0)
+    {
+      viewport = create_icon_view ();
+      gtk_container_add (GTK_CONTAINER (scrolled_window), viewport);
+    }
+  else
     {
-      GtkWidget *content = create_widget_factory_content ();
-      gtk_grid_attach (GTK_GRID (grid), content,
-                       i % 2, i / 2, 1, 1);
-      g_object_unref (content);
+      viewport = gtk_viewport_new (NULL, NULL);
+      gtk_container_add (GTK_CONTAINER (scrolled_window), viewport);
+
+      grid = gtk_grid_new ();
+      gtk_container_add (GTK_CONTAINER (viewport), grid);
+
+      for (i = 0; i < 4; i++)
+        {
+          GtkWidget *content = create_widget_factory_content ();
+          gtk_grid_attach (GTK_GRID (grid), content,
+                           i % 2, i / 2, 1, 1);
+          g_object_unref (content);
+        }
     }
 
   gtk_widget_add_tick_callback (viewport,
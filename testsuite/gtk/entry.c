@@ -306,6 +306,173 @@ test_delete (void)
   g_object_unref (entry);
 }
 
+static GtkEntryCompletion *
+create_completion (void)
+{
+  GtkWidget *entry;
+  GtkEntryCompletion *completion;
+  GtkListStore *store;
+  const gchar *words[][2] = {
+    { "apple", "cherry" },
+    { "applesauce", "cherrystone" },
+    { "apricot", "chestnut" },
+    { "banana", "date" }
+  };
+  gint i;
+
+  store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_STRING);
+  for (i = 0; i < G_N_ELEMENTS (words); i++)
+    gtk_list_store_insert_with_values (store, NULL, -1,
+                                       0, words[i][0],
+                                       1, words[i][1],
+                                       -1);
+
+  completion = gtk_entry_completion_new ();
+  gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (store));
+  gtk_entry_completion_set_text_column (completion, 0);
+  g_object_unref (store);
+
+  entry = gtk_entry_new ();
+  g_object_ref_sink (entry);
+  gtk_entry_set_completion (GTK_ENTRY (entry), completion);
+  g_object_unref (completion);
+
+  return completion;
+}
+
+static void
+free_completion (GtkEntryCompletion *completion)
+{
+  g_object_unref (gtk_entry_completion_get_entry (completion));
+}
+
+/* Returns the common prefix of all rows that are left visible
+ * after completing @text, or %NULL if there are none.
+ */
+static gchar *
+complete (GtkEntryCompletion *completion,
+          const gchar        *text)
+{
+  gtk_entry_set_text (GTK_ENTRY (gtk_entry_completion_get_entry (completion)), text);
+  gtk_entry_completion_complete (completion);
+
+  return gtk_entry_completion_compute_prefix (completion, "");
+}
+
+static void
+assert_completes (GtkEntryCompletion *completion,
+                  const gchar        *text,
+                  const gchar        *expected)
+{
+  gchar *prefix;
+
+  prefix = complete (completion, text);
+  g_assert_cmpstr (prefix, ==, expected);
+  g_free (prefix);
+}
+
+static void
+test_completion_narrow (void)
+{
+  GtkEntryCompletion *completion;
+
+  completion = create_completion ();
+
+  assert_completes (completion, "a", "ap");
+  assert_completes (completion, "app", "apple");
+  assert_completes (completion, "APPLES", "applesauce");
+  assert_completes (completion, "applesx", NULL);
+
+  free_completion (completion);
+}
+
+static void
+test_completion_widen (void)
+{
+  GtkEntryCompletion *completion;
+
+  completion = create_completion ();
+
+  assert_completes (completion, "applesx", NULL);
+  assert_completes (completion, "apples", "applesauce");
+  assert_completes (completion, "app", "apple");
+  assert_completes (completion, "a", "ap");
+  assert_completes (completion, "", "");
+
+  free_completion (completion);
+}
+
+static void
+test_completion_edit (void)
+{
+  GtkEntryCompletion *completion;
+
+  completion = create_completion ();
+
+  assert_completes (completion, "app", "apple");
+  assert_completes (completion, "apr", "apricot");
+  assert_completes (completion, "b", "banana");
+  assert_completes (completion, "x", NULL);
+  assert_completes (completion, "ap", "ap");
+
+  free_completion (completion);
+}
+
+static void
+test_completion_text_column (void)
+{
+  GtkEntryCompletion *completion;
+
+  completion = create_completion ();
+
+  assert_completes (completion, "ch", NULL);
+
+  gtk_entry_completion_set_text_column (completion, 1);
+
+  assert_completes (completion, "ch", "che");
+  assert_completes (completion, "cher", "cherry");
+
+  free_completion (completion);
+}
+
+static void
+test_completion_model (void)
+{
+  GtkEntryCompletion *completion;
+  GtkListStore *store;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+
+  completion = create_completion ();
+
+  assert_completes (completion, "a", "ap");
+
+  /* Changing a row is picked up without a new key */
+  model = gtk_entry_completion_get_model (completion);
+  gtk_tree_model_get_iter_first (model, &iter);
+  gtk_list_store_set (GTK_LIST_STORE (model), &iter, 0, "avocado", -1);
+
+  assert_completes (completion, "a", "a");
+  assert_completes (completion, "ap", "ap");
+
+  /* And so is removing one */
+  gtk_list_store_remove (GTK_LIST_STORE (model), &iter);
+
+  assert_completes (completion, "a", "ap");
+
+  /* Replacing the model refilters everything */
+  store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_STRING);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, "apex", -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, "Apple", -1);
+  gtk_entry_completion_set_model (completion, GTK_TREE_MODEL (store));
+  g_object_unref (store);
+
+  assert_completes (completion, "ap", "");
+  assert_completes (completion, "ape", "apex");
+
+  free_completion (completion);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -314,6 +481,11 @@ main (int   argc,
 
   g_test_add_func ("/entry/delete", test_delete);
   g_test_add_func ("/entry/insert", test_insert);
+  g_test_add_func ("/entry/completion/narrow", test_completion_narrow);
+  g_test_add_func ("/entry/completion/widen", test_completion_widen);
+  g_test_add_func ("/entry/completion/edit", test_completion_edit);
+  g_test_add_func ("/entry/completion/text-column", test_completion_text_column);
+  g_test_add_func ("/entry/completion/model", test_completion_model);
 
   return g_test_run();
 }
@@ -6783,6 +6783,95 @@ specific_bug_679910 (void)
   g_object_unref (store);
 }
 
+static const gchar *prefix_filter_key = "";
+static gint prefix_filter_calls = 0;
+
+static gboolean
+prefix_visible_func (GtkTreeModel *model,
+                     GtkTreeIter  *iter,
+                     gpointer      data)
+{
+  gchar *str;
+  gboolean visible;
+
+  prefix_filter_calls++;
+
+  gtk_tree_model_get (model, iter, 0, &str, -1);
+  visible = g_str_has_prefix (str, prefix_filter_key);
+  g_free (str);
+
+  return visible;
+}
+
+static void
+count_signal (GtkTreeModel *model,
+              GtkTreePath  *path,
+              gpointer      data)
+{
+  (*(gint *) data)++;
+}
+
+static void
+refilter_with_change (void)
+{
+  static const gchar *words[] = {
+    "a", "ab", "abc", "abd", "b", "ba", "bab", "c", "abcd", "aa"
+  };
+  GtkListStore *store;
+  GtkTreeModel *filter;
+  GtkWidget *tree_view;
+  gint n_changed = 0, n_deleted = 0, n_inserted = 0;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < G_N_ELEMENTS (words); i++)
+    gtk_list_store_insert_with_values (store, NULL, i, 0, words[i], -1);
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_func (GTK_TREE_MODEL_FILTER (filter),
+                                          prefix_visible_func, NULL, NULL);
+  tree_view = gtk_tree_view_new_with_model (filter);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 10);
+
+  g_signal_connect (filter, "row-changed", G_CALLBACK (count_signal), &n_changed);
+  g_signal_connect (filter, "row-deleted", G_CALLBACK (count_signal), &n_deleted);
+  g_signal_connect (filter, "row-inserted", G_CALLBACK (count_signal), &n_inserted);
+
+  /* Narrowing only looks at visible rows */
+  prefix_filter_key = "a";
+  prefix_filter_calls = 0;
+  gtk_tree_model_filter_refilter_with_change (GTK_TREE_MODEL_FILTER (filter),
+                                              GTK_TREE_MODEL_FILTER_CHANGE_MORE_STRICT);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 6);
+  g_assert_cmpint (n_deleted, ==, 4);
+
+  prefix_filter_key = "abc";
+  prefix_filter_calls = 0;
+  gtk_tree_model_filter_refilter_with_change (GTK_TREE_MODEL_FILTER (filter),
+                                              GTK_TREE_MODEL_FILTER_CHANGE_MORE_STRICT);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 2);
+  g_assert_cmpint (n_deleted, ==, 8);
+  /* the six visible rows, and again for each of the four hidden ones */
+  g_assert_cmpint (prefix_filter_calls, ==, 6 + 4);
+
+  /* Widening only looks at hidden rows */
+  prefix_filter_key = "ab";
+  prefix_filter_calls = 0;
+  gtk_tree_model_filter_refilter_with_change (GTK_TREE_MODEL_FILTER (filter),
+                                              GTK_TREE_MODEL_FILTER_CHANGE_LESS_STRICT);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, NULL), ==, 4);
+  g_assert_cmpint (n_inserted, ==, 2);
+  /* the eight hidden rows, and again for the rows that are pulled in */
+  g_assert_cmpint (prefix_filter_calls, <=, 8 + 2);
+
+  /* Rows that stay visible are left alone */
+  g_assert_cmpint (n_changed, ==, 0);
+
+  gtk_widget_destroy (tree_view);
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
 /* main */
 
 void
@@ -7030,6 +7119,9 @@ register_filter_model_tests (void)
   g_test_add_func ("/TreeModelFilter/remove/vroot-ancestor",
                    remove_vroot_ancestor);
 
+  g_test_add_func ("/TreeModelFilter/refilter/with-change",
+                   refilter_with_change);
+
   /* Reference counting */
   g_test_add_func ("/TreeModelFilter/ref-count/single-level",
                    ref_count_single_level);
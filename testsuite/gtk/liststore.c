@@ -455,6 +455,221 @@ list_store_test_insert_before_NULL (void)
   g_object_unref (store);
 }
 
+static void
+count_inserted (GtkTreeModel *model,
+                GtkTreePath  *path,
+                GtkTreeIter  *iter,
+                gpointer      data)
+{
+  (*(gint *) data)++;
+}
+
+static void
+list_store_test_insert_rows_from_arrays (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  GValue ints[4] = { G_VALUE_INIT, };
+  GValue strings[4] = { G_VALUE_INIT, };
+  GValue *values[2] = { ints, strings };
+  gint columns[2] = { 0, 1 };
+  const gchar *names[4] = { "a", "b", "c", "d" };
+  gint expected[6] = { -1, 0, 1, 2, 3, -2 };
+  gint n_inserted = 0;
+  gint i, v;
+  gchar *s;
+
+  store = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+  g_signal_connect (store, "row-inserted", G_CALLBACK (count_inserted), &n_inserted);
+
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, -1, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, -2, -1);
+
+  for (i = 0; i < 4; i++)
+    {
+      g_value_init (&ints[i], G_TYPE_INT);
+      g_value_set_int (&ints[i], i);
+      g_value_init (&strings[i], G_TYPE_STRING);
+      g_value_set_static_string (&strings[i], names[i]);
+    }
+
+  gtk_list_store_insert_rows_from_arrays (store, 1, 4, columns, values, 2);
+
+  g_assert_cmpint (n_inserted, ==, 6);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 6);
+
+  i = 0;
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &v, 1, &s, -1);
+      g_assert_cmpint (v, ==, expected[i]);
+      if (v >= 0)
+        g_assert_cmpstr (s, ==, names[v]);
+      else
+        g_assert (s == NULL);
+      g_assert (iter_position (store, &iter, i));
+      g_free (s);
+      i++;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+
+  /* Sorted stores put every new row in its place */
+  gtk_list_store_clear (store);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 0, GTK_SORT_DESCENDING);
+  gtk_list_store_insert_rows_from_arrays (store, -1, 4, columns, values, 1);
+
+  i = 3;
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &v, -1);
+      g_assert_cmpint (v, ==, i);
+      i--;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+  g_assert_cmpint (i, ==, -1);
+
+  for (i = 0; i < 4; i++)
+    {
+      g_value_unset (&ints[i]);
+      g_value_unset (&strings[i]);
+    }
+  g_object_unref (store);
+}
+
+static void
+reentrant_inserted (GtkTreeModel *model,
+                    GtkTreePath  *path,
+                    GtkTreeIter  *iter,
+                    gpointer      data)
+{
+  GtkTreePath *real_path;
+  GtkTreeIter next;
+  gint v;
+
+  /* The path must match where the row really is */
+  real_path = gtk_tree_model_get_path (model, iter);
+  g_assert_cmpint (gtk_tree_path_compare (path, real_path), ==, 0);
+  gtk_tree_path_free (real_path);
+
+  gtk_tree_model_get (model, iter, 0, &v, -1);
+
+  if (v == 0)
+    {
+      /* Remove the row the next one would be inserted in front of */
+      next = *iter;
+      g_assert (gtk_tree_model_iter_next (model, &next));
+      gtk_list_store_remove (GTK_LIST_STORE (model), &next);
+    }
+  else if (v == 2)
+    {
+      /* Move all following rows down */
+      gtk_list_store_insert_with_values (GTK_LIST_STORE (model), NULL, 0, 0, 100, -1);
+    }
+}
+
+static void
+list_store_test_insert_rows_from_arrays_reentrant (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  GValue ints[4] = { G_VALUE_INIT, };
+  GValue *values[1] = { ints };
+  gint columns[1] = { 0 };
+  gint expected[6] = { 100, -1, 0, 1, 3, 2 };
+  gint i, v;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, -1, -1);
+  gtk_list_store_insert_with_values (store, NULL, -1, 0, -2, -1);
+
+  for (i = 0; i < 4; i++)
+    {
+      g_value_init (&ints[i], G_TYPE_INT);
+      g_value_set_int (&ints[i], i);
+    }
+
+  g_signal_connect (store, "row-inserted", G_CALLBACK (reentrant_inserted), NULL);
+
+  /* Same as inserting the rows at positions 1 to 4 one by one */
+  gtk_list_store_insert_rows_from_arrays (store, 1, 4, columns, values, 1);
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, 6);
+
+  i = 0;
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &v, -1);
+      g_assert_cmpint (v, ==, expected[i]);
+      i++;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+
+  for (i = 0; i < 4; i++)
+    g_value_unset (&ints[i]);
+  g_object_unref (store);
+}
+
+/* sorting */
+static void
+list_store_test_sort_default (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  const gchar *names[4] = { "c", NULL, "a", "b" };
+  gint expected[5] = { -1, -1, 2, 3, 0 };
+  gint i, v;
+
+  store = gtk_list_store_new (3, G_TYPE_INT, G_TYPE_STRING, G_TYPE_DOUBLE);
+
+  for (i = 0; i < 4; i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, i, 1, names[i], 2, -i * 0.5, -1);
+  /* a row that has never been set sorts like default values */
+  gtk_list_store_append (store, &iter);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 1, GTK_SORT_ASCENDING);
+
+  i = 0;
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  do
+    {
+      gchar *s;
+
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &v, 1, &s, -1);
+      /* the unset row and the NULL string compare equal */
+      if (i < 2)
+        g_assert (s == NULL);
+      else
+        g_assert_cmpint (v, ==, expected[i]);
+      g_free (s);
+      i++;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+  g_assert_cmpint (i, ==, 5);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store), 2, GTK_SORT_DESCENDING);
+
+  /* the first two rows both hold 0.0 */
+  i = 0;
+  g_assert (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter));
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &v, -1);
+      if (i < 2)
+        g_assert_cmpint (v, ==, 0);
+      else
+        g_assert_cmpint (v, ==, i - 1);
+      i++;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter));
+  g_assert_cmpint (i, ==, 5);
+
+  g_object_unref (store);
+}
+
 /* setting values */
 static void
 list_store_set_gvalue_to_transform (void)
@@ -1033,11 +1248,19 @@ register_list_store_tests (void)
 		   list_store_test_insert_before);
   g_test_add_func ("/ListStore/insert-before-NULL",
 		   list_store_test_insert_before_NULL);
+  g_test_add_func ("/ListStore/insert-rows-from-arrays",
+		   list_store_test_insert_rows_from_arrays);
+  g_test_add_func ("/ListStore/insert-rows-from-arrays-reentrant",
+		   list_store_test_insert_rows_from_arrays_reentrant);
 
   /* setting values (FIXME) */
   g_test_add_func ("/ListStore/set-gvalue-to-transform",
                    list_store_set_gvalue_to_transform);
 
+  /* sorting */
+  g_test_add_func ("/ListStore/sort-default",
+                   list_store_test_sort_default);
+
   /* removal */
   g_test_add ("/ListStore/remove-begin", ListStore, NULL,
 	      list_store_setup, list_store_test_remove_begin,
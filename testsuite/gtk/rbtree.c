@@ -428,6 +428,130 @@ test_remove_root (void)
   _gtk_rbtree_free (tree);
 }
 
+static void
+test_fill (void)
+{
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  guint n, i;
+
+  for (n = 0; n <= 100; n++)
+    {
+      tree = _gtk_rbtree_new ();
+      _gtk_rbtree_fill (tree, n, 3, TRUE);
+      _gtk_rbtree_test (tree);
+
+      if (n == 0)
+        {
+          g_assert (_gtk_rbtree_is_nil (tree->root));
+          _gtk_rbtree_free (tree);
+          continue;
+        }
+
+      g_assert (tree->root->count == n);
+      g_assert (tree->root->total_count == n);
+      g_assert (tree->root->offset == n * 3);
+
+      for (node = _gtk_rbtree_first (tree), i = 0;
+           node != NULL;
+           node = _gtk_rbtree_next (tree, node), i++)
+        {
+          g_assert (_gtk_rbtree_node_find_offset (tree, node) == i * 3);
+          g_assert (_gtk_rbtree_find_count (tree, i + 1) == node);
+        }
+      g_assert (i == n);
+
+      for (node = _gtk_rbtree_first (tree), i = 0;
+           node != NULL;
+           node = _gtk_rbtree_next (tree, node), i++)
+        _gtk_rbtree_node_set_height (tree, node, i);
+      _gtk_rbtree_test (tree);
+
+      /* A filled tree must keep working like any other */
+      node = _gtk_rbtree_find_count (tree, n / 2 + 1);
+      _gtk_rbtree_insert_after (tree, node, 1, TRUE);
+      _gtk_rbtree_insert_before (tree, node, 1, TRUE);
+      _gtk_rbtree_test (tree);
+      _gtk_rbtree_remove_node (tree, node);
+      _gtk_rbtree_test (tree);
+      g_assert (tree->root->count == n + 1);
+
+      _gtk_rbtree_free (tree);
+    }
+}
+
+static void
+test_fill_children (void)
+{
+  GtkRBTree *tree, *children;
+  GtkRBNode *node;
+
+  tree = create_rbtree (1, 8, FALSE);
+  g_assert (!GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+
+  node = _gtk_rbtree_find_count (tree, 3);
+  g_assert (node->children == NULL);
+  children = _gtk_rbtree_new ();
+  children->parent_tree = tree;
+  children->parent_node = node;
+  node->children = children;
+
+  _gtk_rbtree_fill (children, 50, 2, FALSE);
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->total_count == 8 + 50);
+  g_assert (GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+
+  for (node = _gtk_rbtree_first (children);
+       node != NULL;
+       node = _gtk_rbtree_next (children, node))
+    {
+      g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID));
+      _gtk_rbtree_node_mark_valid (children, node);
+    }
+
+  _gtk_rbtree_test (tree);
+  g_assert (!GTK_RBNODE_FLAG_SET (tree->root, GTK_RBNODE_DESCENDANTS_INVALID));
+
+  _gtk_rbtree_free (tree);
+}
+
+static void
+test_fill_perf (void)
+{
+  guint n = g_test_perf () ? 1000000 : 1000;
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  double elapsed;
+  guint i;
+
+  g_test_timer_start ();
+
+  tree = _gtk_rbtree_new ();
+  node = NULL;
+  for (i = 0; i < n; i++)
+    node = _gtk_rbtree_insert_after (tree, node, 1, FALSE);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "inserting %u items one by one: %gsec", n, elapsed);
+
+  _gtk_rbtree_test (tree);
+  _gtk_rbtree_free (tree);
+
+  g_test_timer_start ();
+
+  tree = _gtk_rbtree_new ();
+  _gtk_rbtree_fill (tree, n, 1, FALSE);
+
+  elapsed = g_test_timer_elapsed ();
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed, "filling rbtree with %u items: %gsec", n, elapsed);
+
+  _gtk_rbtree_test (tree);
+  g_assert (tree->root->count == n);
+  _gtk_rbtree_free (tree);
+}
+
 static gint *
 fisher_yates_shuffle (guint n_items)
 {
@@ -520,6 +644,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/rbtree/remove_node", test_remove_node);
   g_test_add_func ("/rbtree/remove_root", test_remove_root);
   g_test_add_func ("/rbtree/reorder", test_reorder);
+  g_test_add_func ("/rbtree/fill", test_fill);
+  g_test_add_func ("/rbtree/fill_children", test_fill_children);
+  g_test_add_func ("/rbtree/fill_perf", test_fill_perf);
 
   return g_test_run ();
 }
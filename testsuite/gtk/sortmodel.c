@@ -1029,6 +1029,77 @@ sorted_insert (void)
   g_object_unref (ref_model);
 }
 
+static void
+check_string_order (GtkTreeModel *model,
+                    GtkSortType   order,
+                    gint          n_rows)
+{
+  GtkTreeIter iter;
+  gchar *prev = NULL;
+  gchar *str;
+  gint n = 0;
+
+  if (!gtk_tree_model_get_iter_first (model, &iter))
+    return;
+
+  do
+    {
+      gtk_tree_model_get (model, &iter, 0, &str, -1);
+
+      if (prev)
+        {
+          if (order == GTK_SORT_ASCENDING)
+            g_assert_cmpint (g_utf8_collate (prev, str), <=, 0);
+          else
+            g_assert_cmpint (g_utf8_collate (prev, str), >=, 0);
+        }
+
+      g_free (prev);
+      prev = str;
+      n++;
+    }
+  while (gtk_tree_model_iter_next (model, &iter));
+
+  g_free (prev);
+  g_assert_cmpint (n, ==, n_rows);
+}
+
+static void
+sort_large_string_level (void)
+{
+  GtkListStore *store;
+  GtkTreeModel *sort_model;
+  GtkWidget *tree_view;
+  gint i;
+
+  /* Big enough to be sorted in several chunks */
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 30000; i++)
+    {
+      gchar *str;
+
+      str = g_strdup_printf ("%c row %u", 'a' + g_test_rand_int_range (0, 26),
+                             g_test_rand_int ());
+      gtk_list_store_insert_with_values (store, NULL, -1, 0, str, -1);
+      g_free (str);
+    }
+
+  sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+  tree_view = gtk_tree_view_new_with_model (sort_model);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_ASCENDING);
+  check_string_order (sort_model, GTK_SORT_ASCENDING, 30000);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                        0, GTK_SORT_DESCENDING);
+  check_string_order (sort_model, GTK_SORT_DESCENDING, 30000);
+
+  gtk_widget_destroy (tree_view);
+  g_object_unref (sort_model);
+  g_object_unref (store);
+}
+
 
 static void
 specific_bug_300089 (void)
@@ -1230,6 +1301,8 @@ register_sort_model_tests (void)
                    rows_reordered_two_levels);
   g_test_add_func ("/TreeModelSort/sorted-insert",
                    sorted_insert);
+  g_test_add_func ("/TreeModelSort/sort-large-string-level",
+                   sort_large_string_level);
 
   g_test_add_func ("/TreeModelSort/specific/bug-300089",
                    specific_bug_300089);
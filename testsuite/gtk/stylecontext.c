@@ -256,6 +256,72 @@ test_match (void)
   g_object_unref (context);
 }
 
+static void
+test_match_ancestors (void)
+{
+  GtkStyleContext *context;
+  GtkWidgetPath *path;
+  GtkCssProvider *provider;
+  GError *error;
+  const gchar *data;
+  GdkRGBA color;
+  GdkRGBA expected;
+
+  error = NULL;
+  provider = gtk_css_provider_new ();
+
+  gdk_rgba_parse (&expected, "#fff");
+
+  context = gtk_style_context_new ();
+
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_WINDOW);
+  gtk_widget_path_append_type (path, GTK_TYPE_BOX);
+  gtk_widget_path_append_type (path, GTK_TYPE_BUTTON);
+  gtk_widget_path_iter_set_name (path, 0, "mywindow");
+  gtk_widget_path_iter_add_class (path, 0, "outer");
+  gtk_widget_path_iter_add_region (path, 1, "row", 0);
+  gtk_style_context_set_path (context, path);
+  gtk_widget_path_free (path);
+
+  gtk_style_context_add_provider (context,
+                                  GTK_STYLE_PROVIDER (provider),
+                                  GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  /* Selectors that can be rejected by the ancestor filter must not
+   * hide selectors that match */
+  data = "* { color: #f00 }\n"
+         ".outer GtkButton { color: #fff }\n"
+         ".unknown GtkButton { color: #000 }\n"
+         "#otherwindow GtkButton { color: #000 }\n"
+         "GtkPaned > GtkButton { color: #000 }";
+  gtk_css_provider_load_from_data (provider, data, -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_invalidate (context);
+  gtk_style_context_get_color (context, GTK_STATE_FLAG_NORMAL, &color);
+  g_assert (gdk_rgba_equal (&color, &expected));
+
+  data = "* { color: #f00 }\n"
+         "GtkContainer > GtkButton { color: #fff }\n"
+         "GtkScrollable GtkButton { color: #000 }";
+  gtk_css_provider_load_from_data (provider, data, -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_invalidate (context);
+  gtk_style_context_get_color (context, GTK_STATE_FLAG_NORMAL, &color);
+  g_assert (gdk_rgba_equal (&color, &expected));
+
+  data = "* { color: #f00 }\n"
+         "#mywindow row GtkButton { color: #fff }";
+  gtk_css_provider_load_from_data (provider, data, -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_invalidate (context);
+  gtk_style_context_get_color (context, GTK_STATE_FLAG_NORMAL, &color);
+  g_assert (gdk_rgba_equal (&color, &expected));
+
+  g_object_unref (provider);
+  g_object_unref (context);
+}
+
 static void
 test_style_property (void)
 {
@@ -343,6 +409,141 @@ test_basic_properties (void)
   g_object_unref (context);
 }
 
+static GtkStyleContext *
+create_context_for_class (const gchar *class_name)
+{
+  GtkStyleContext *context;
+  GtkWidgetPath *path;
+
+  context = gtk_style_context_new ();
+
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_WINDOW);
+  gtk_widget_path_append_type (path, GTK_TYPE_BUTTON);
+  gtk_widget_path_iter_add_class (path, 1, class_name);
+  gtk_style_context_set_path (context, path);
+  gtk_widget_path_free (path);
+
+  return context;
+}
+
+static void
+assert_context_color (GtkStyleContext *context,
+                      const gchar     *expected_color)
+{
+  GdkRGBA color;
+  GdkRGBA expected;
+
+  gdk_rgba_parse (&expected, expected_color);
+  gtk_style_context_get_color (context, GTK_STATE_FLAG_NORMAL, &color);
+  g_assert (gdk_rgba_equal (&color, &expected));
+}
+
+static void
+test_shared_styles (void)
+{
+  GtkStyleContext *context1, *context2, *context3;
+  GtkCssProvider *provider;
+  GError *error;
+
+  error = NULL;
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "GtkButton { color: #f00 }\n"
+                                   ".other { color: #00f }",
+                                   -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
+                                             GTK_STYLE_PROVIDER (provider),
+                                             GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  context1 = create_context_for_class ("shared");
+  context2 = create_context_for_class ("shared");
+  context3 = create_context_for_class ("other");
+
+  assert_context_color (context1, "#f00");
+  assert_context_color (context2, "#f00");
+  assert_context_color (context3, "#00f");
+
+  /* changing the provider must not return stale shared values */
+  gtk_css_provider_load_from_data (provider,
+                                   "GtkButton { color: #0f0 }",
+                                   -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_invalidate (context1);
+  gtk_style_context_invalidate (context2);
+  gtk_style_context_invalidate (context3);
+
+  assert_context_color (context1, "#0f0");
+  assert_context_color (context2, "#0f0");
+  assert_context_color (context3, "#0f0");
+
+  /* values must stay valid after another context sharing them is gone */
+  g_object_unref (context1);
+  assert_context_color (context2, "#0f0");
+
+  g_object_unref (context2);
+  g_object_unref (context3);
+
+  gtk_style_context_remove_provider_for_screen (gdk_screen_get_default (),
+                                                GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
+static void
+pathless_context_changed (GtkStyleContext *pathless,
+                          GtkStyleContext *context)
+{
+  const gchar *expected;
+
+  expected = g_object_get_data (G_OBJECT (context), "expected-color");
+  if (expected == NULL)
+    return;
+
+  /* This runs while the cascade is still emitting its change
+   * notification, the shared values must be gone already */
+  gtk_style_context_invalidate (context);
+  assert_context_color (context, expected);
+  g_object_set_data (G_OBJECT (context), "checked", GINT_TO_POINTER (TRUE));
+}
+
+static void
+test_shared_styles_changed (void)
+{
+  GtkStyleContext *pathless, *context;
+  GtkCssProvider *provider;
+  GError *error;
+
+  error = NULL;
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider, "GtkButton { color: #f00 }", -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
+                                             GTK_STYLE_PROVIDER (provider),
+                                             GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  context = create_context_for_class ("changed");
+  assert_context_color (context, "#f00");
+
+  /* Contexts without a widget or a path emit "changed" right away
+   * when the cascade changes */
+  pathless = gtk_style_context_new ();
+  g_signal_connect (pathless, "changed",
+                    G_CALLBACK (pathless_context_changed), context);
+
+  g_object_set_data (G_OBJECT (context), "expected-color", "#0f0");
+  gtk_css_provider_load_from_data (provider, "GtkButton { color: #0f0 }", -1, &error);
+  g_assert_no_error (error);
+  g_assert (g_object_get_data (G_OBJECT (context), "checked"));
+
+  g_object_unref (pathless);
+  g_object_unref (context);
+
+  gtk_style_context_remove_provider_for_screen (gdk_screen_get_default (),
+                                                GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -352,8 +553,11 @@ main (int argc, char *argv[])
   g_test_add_func ("/style/parse/selectors", test_parse_selectors);
   g_test_add_func ("/style/path", test_path);
   g_test_add_func ("/style/match", test_match);
+  g_test_add_func ("/style/match/ancestors", test_match_ancestors);
   g_test_add_func ("/style/style-property", test_style_property);
   g_test_add_func ("/style/basic", test_basic_properties);
+  g_test_add_func ("/style/shared", test_shared_styles);
+  g_test_add_func ("/style/shared/changed", test_shared_styles_changed);
 
   return g_test_run ();
 }
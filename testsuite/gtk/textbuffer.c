@@ -1319,6 +1319,39 @@ test_tag (void)
   g_object_unref (buffer);
 }
 
+static void
+check_insert_end (GtkTextBuffer *buffer,
+                  gint           offset,
+                  const gchar   *str)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_set_text (buffer, "first line\nsecond", -1);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, offset);
+  gtk_text_buffer_insert (buffer, &iter, str, -1);
+
+  g_assert_cmpint (gtk_text_iter_get_offset (&iter), ==,
+                   offset + g_utf8_strlen (str, -1));
+}
+
+static void
+test_insert_end (void)
+{
+  GtkTextBuffer *buffer;
+
+  buffer = gtk_text_buffer_new (NULL);
+
+  check_insert_end (buffer, 0, "abc");
+  check_insert_end (buffer, 5, "abc");
+  check_insert_end (buffer, 5, "ab\ncd\nef");
+  check_insert_end (buffer, 5, "ab\n\n");
+  check_insert_end (buffer, 13, "\xc3\xa4b\r\n\xc3\xb6");
+  check_insert_end (buffer, 17, "ab\r");
+  check_insert_end (buffer, 17, "\xe2\x80\xa9x");
+
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1336,6 +1369,7 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Get and Set", test_get_set);
   g_test_add_func ("/TextBuffer/Fill and Empty", test_fill_empty);
   g_test_add_func ("/TextBuffer/Tag", test_tag);
+  g_test_add_func ("/TextBuffer/Insert end", test_insert_end);
   
   return g_test_run();
 }
@@ -253,6 +253,13 @@ test_search_caseless (void)
   check_found_backward ("This is some Foo\nFoo text", "foo\nfoo", flags, 13, 20, "Foo\nFoo");
   check_found_backward ("This is some \303\200\n\303\200 text", "\303\240\n\303\240", flags, 13, 16, "\303\200\n\303\200");
   check_found_backward ("This is some \303\200\n\303\200 text", "a\314\200\na\314\200", flags, 13, 16, "\303\200\n\303\200");
+
+  /* ASCII needles in text with characters that casefold to ASCII */
+  check_found_forward ("Some \342\204\252ilo", "kilo", flags, 5, 9, "\342\204\252ilo");
+  check_found_backward ("Some \342\204\252ilo", "KILO", flags, 5, 9, "\342\204\252ilo");
+  check_found_forward ("foo \303\240\nFOO\nBar", "foo\nbar", flags, 6, 13, "FOO\nBar");
+  check_found_backward ("foo\nBar \303\240\nfoo", "FOO\nbar", flags, 0, 7, "foo\nBar");
+  check_not_found ("This is some foo text", "fooo", flags);
 }
 
 int
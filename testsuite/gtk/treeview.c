@@ -226,6 +226,67 @@ test_row_separator_height (void)
   gtk_widget_destroy (tree_view);
 }
 
+static void
+rows_validated_cb (GtkTreeView *tree_view,
+                   gboolean    *validated)
+{
+  *validated = TRUE;
+}
+
+static void
+test_rows_validated (void)
+{
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  GtkListStore *store;
+  GtkWidget *window;
+  GtkWidget *tree_view;
+  GdkRectangle first, last;
+  gboolean validated = FALSE;
+  int i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 1000; i++)
+    gtk_list_store_insert_with_values (store, &iter, i,
+                                       0, i % 3 ? "Row content" : "Row\ncontent",
+                                       -1);
+
+  window = gtk_offscreen_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view),
+                                               0,
+                                               "Test",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  g_signal_connect (tree_view, "rows-validated",
+                    G_CALLBACK (rows_validated_cb), &validated);
+
+  gtk_container_add (GTK_CONTAINER (window), tree_view);
+  gtk_widget_show_all (window);
+
+  while (!validated)
+    gtk_main_iteration ();
+
+  /* Every row has been measured, so rows with the same content have
+   * the same height no matter where they are */
+  path = gtk_tree_path_new_from_indices (0, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view),
+                                     path, NULL, &first);
+  gtk_tree_path_free (path);
+  path = gtk_tree_path_new_from_indices (999, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view),
+                                     path, NULL, &last);
+  gtk_tree_path_free (path);
+
+  g_assert_cmpint (first.height, ==, last.height);
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -238,6 +299,8 @@ main (int    argc,
                    test_select_collapsed_row);
   g_test_add_func ("/TreeView/sizing/row-separator-height",
                    test_row_separator_height);
+  g_test_add_func ("/TreeView/sizing/rows-validated",
+                   test_rows_validated);
 
   return g_test_run ();
 }